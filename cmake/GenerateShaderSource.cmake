@@ -25,30 +25,51 @@ function(add_shader_embedding_target TARGET_NAME INPUT_DIR OUTPUT_FILE)
             continue()
         endif ()
 
-        set(SPV_FILE "${INTERMEDIATE_DIR}/${FILE_NAME}.spv")
-
-        # Add Vulkan binding shifts to match NVRHI's VulkanBindingOffsets defaults:
-        # shaderResource = 0, sampler = 128, constantBuffer = 256, unorderedAccess = 384
-        execute_process(
-                COMMAND ${DXC_EXECUTABLE} -T ${PROFILE} -E main -spirv
-                        -fvk-t-shift 0 0
-                        -fvk-s-shift 128 0
-                        -fvk-b-shift 256 0
-                        -fvk-u-shift 384 0
-                        -Fo "${SPV_FILE}" "${SHADER_PATH}"
-                RESULT_VARIABLE DXC_RESULT
-                ERROR_VARIABLE DXC_ERROR
-        )
-
-        if (NOT DXC_RESULT EQUAL 0)
-            message(FATAL_ERROR "DXC Compile Error for ${FILE_NAME}: ${DXC_ERROR}")
-        endif ()
+        # Every "// @permutation NAME" line adds a build with NAME defined to 1, embedded as <shader>_<name>.
+        # The plain build, without any of the defines, keeps the shader's own name.
+        file(STRINGS "${SHADER_PATH}" PERMUTATION_LINES REGEX "^// @permutation [A-Z0-9_]+$")
+        set(PERMUTATIONS "PLAIN")
+        foreach (PERMUTATION_LINE ${PERMUTATION_LINES})
+            string(REGEX REPLACE "^// @permutation " "" PERMUTATION "${PERMUTATION_LINE}")
+            list(APPEND PERMUTATIONS "${PERMUTATION}")
+        endforeach ()
+
+        foreach (PERMUTATION ${PERMUTATIONS})
+            if (PERMUTATION STREQUAL "PLAIN")
+                set(DEFINE_ARGS "")
+                set(VAR_NAME "${SAFE_VAR_NAME}")
+            else ()
+                set(DEFINE_ARGS -D "${PERMUTATION}=1")
+                string(TOLOWER "${PERMUTATION}" PERMUTATION_SUFFIX)
+                set(VAR_NAME "${SAFE_VAR_NAME}_${PERMUTATION_SUFFIX}")
+            endif ()
+
+            set(SPV_FILE "${INTERMEDIATE_DIR}/${VAR_NAME}.spv")
+
+            # Add Vulkan binding shifts to match NVRHI's VulkanBindingOffsets defaults:
+            # shaderResource = 0, sampler = 128, constantBuffer = 256, unorderedAccess = 384
+            execute_process(
+                    COMMAND ${DXC_EXECUTABLE} -T ${PROFILE} -E main -spirv
+                            -fvk-t-shift 0 0
+                            -fvk-s-shift 128 0
+                            -fvk-b-shift 256 0
+                            -fvk-u-shift 384 0
+                            ${DEFINE_ARGS}
+                            -Fo "${SPV_FILE}" "${SHADER_PATH}"
+                    RESULT_VARIABLE DXC_RESULT
+                    ERROR_VARIABLE DXC_ERROR
+            )
+
+            if (NOT DXC_RESULT EQUAL 0)
+                message(FATAL_ERROR "DXC Compile Error for ${FILE_NAME} (${PERMUTATION}): ${DXC_ERROR}")
+            endif ()
 
-        file(READ "${SPV_FILE}" HEX_CONTENT HEX)
-        file(SIZE "${SPV_FILE}" BIN_SIZE)
-        string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1, " HEX_LIST "${HEX_CONTENT}")
+            file(READ "${SPV_FILE}" HEX_CONTENT HEX)
+            file(SIZE "${SPV_FILE}" BIN_SIZE)
+            string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1, " HEX_LIST "${HEX_CONTENT}")
 
-        string(APPEND HEADER_CONTENT "    export constexpr std::array<std::uint8_t, ${BIN_SIZE}> ${SAFE_VAR_NAME} = { ${HEX_LIST} };\n")
+            string(APPEND HEADER_CONTENT "    export constexpr std::array<std::uint8_t, ${BIN_SIZE}> ${VAR_NAME} = { ${HEX_LIST} };\n")
+        endforeach ()
     endforeach ()
 
     string(APPEND HEADER_CONTENT "}\n")
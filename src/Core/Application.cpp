@@ -3,6 +3,9 @@ module Core.Application;
 import Core.Prelude;
 import Vendor.ApplicationAPI;
 import Render.Swapchain;
+import Render.PipelineCache;
+import Render.FrameGraph;
+import Render.TextureUploader;
 
 import "SDL3/SDL.h";
 import "SDL3/SDL_video.h";
@@ -41,11 +44,14 @@ Engine {
         SelectPhysicalDevice();
         CreateSurface();
         CreateLogicalDevice();
+        CreatePipelineCache(info);
         InitNVRHI();
         CreateSwapchain();
         CreateSyncObjects();
 
         mCommandList = mNvrhiDevice->createCommandList();
+        mFrameGraph = std::make_unique<FrameGraph>(mNvrhiDevice);
+        mTextureUploader = std::make_unique<TextureUploader>(mNvrhiDevice, static_cast<bool>(mVkTransferQueue));
 
         mLastFrameTimestamp = std::chrono::steady_clock::now();
     }
@@ -70,11 +76,10 @@ Engine {
         while (mRunning) {
             ProcessEvents();
 
+            // Every resize event since the last frame is handled by this one recreation
             if (mNeedsResize) {
                 RecreateSwapchain();
                 mNeedsResize = false;
-                mCurrentFrameIndex = 0;
-                continue;
             }
 
             auto now = std::chrono::steady_clock::now();
@@ -88,6 +93,12 @@ Engine {
                 RenderFrame();
 
             OnPostRender();
+
+            // Layers attached before Run() have built their pipelines by the end of the first frame
+            if (!mPipelineCreationReported) {
+                ReportPipelineCreation();
+                mPipelineCreationReported = true;
+            }
         }
 
         mNvrhiDevice->waitForIdle();
@@ -98,7 +109,10 @@ Engine {
 
         // 1. Clear NVRHI resources - PlatformSwapchain handles its own cleanup
         mSwapchain = PlatformSwapchain{};
+        mRetiredSwapchains.clear();
 
+        mTextureUploader.reset();
+        mFrameGraph.reset();
         mCommandList = nullptr;
 
         // 2. Destroy NVRHI device (needs Vulkan device to clean up)
@@ -110,6 +124,12 @@ Engine {
         }
         mAcquireSemaphores.clear();
 
+        // 4. Persist the pipeline cache while the device can still read it back
+        if (mPipelineCache) {
+            mPipelineCache->Save();
+            mPipelineCache.reset();
+        }
+
         // 5. Destroy debug messenger
         if (mDebugMessenger) {
             mVkInstance.get().destroyDebugUtilsMessengerEXT(mDebugMessenger);
@@ -117,6 +137,7 @@ Engine {
         }
 
         // 6. Clear Vulkan objects (in reverse order of creation)
+        mVkTransferQueue.reset();
         mVkQueue.reset();
         mVkDevice.reset();
         mVkSurface.reset();
@@ -257,10 +278,22 @@ Engine {
 
     void Application::CreateLogicalDevice() {
         float queuePriority = 1.0f;
-        vk::DeviceQueueCreateInfo queueInfo;
-        queueInfo.queueFamilyIndex = 0;
-        queueInfo.queueCount = 1;
-        queueInfo.pQueuePriorities = &queuePriority;
+        std::vector<vk::DeviceQueueCreateInfo> queueInfos(1);
+        queueInfos[0].queueFamilyIndex = 0;
+        queueInfos[0].queueCount = 1;
+        queueInfos[0].pQueuePriorities = &queuePriority;
+
+        // A transfer-only family is usually backed by the copy engines, uploads there run beside rendering
+        std::vector<vk::QueueFamilyProperties> queueFamilies = mVkPhysicalDevice.get().getQueueFamilyProperties();
+        for (uint32_t i = 1; i < queueFamilies.size(); ++i) {
+            const vk::QueueFlags flags = queueFamilies[i].queueFlags;
+            if ((flags & vk::QueueFlagBits::eTransfer) &&
+                !(flags & (vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eCompute))) {
+                mTransferQueueFamily = i;
+                queueInfos.push_back(vk::DeviceQueueCreateInfo({}, i, 1, &queuePriority));
+                break;
+            }
+        }
 
         const char *deviceExtensions[] = {
             vk::KHRSwapchainExtensionName,
@@ -280,12 +313,16 @@ Engine {
         features12.runtimeDescriptorArray = vk::True;
         features12.shaderSampledImageArrayNonUniformIndexing = vk::True;
         features12.descriptorBindingPartiallyBound = vk::True;
+        // Bindless texture tables are written in place while earlier frames still use them
+        features12.descriptorBindingSampledImageUpdateAfterBind = vk::True;
+        features12.descriptorBindingUpdateUnusedWhilePending = vk::True;
+        features12.descriptorBindingVariableDescriptorCount = vk::True;
         features12.timelineSemaphore = vk::True; // Enable timeline semaphore for NVRHI
 
         vk::DeviceCreateInfo devInfo;
         devInfo.pNext = &features12;
-        devInfo.queueCreateInfoCount = 1;
-        devInfo.pQueueCreateInfos = &queueInfo;
+        devInfo.queueCreateInfoCount = static_cast<uint32_t>(queueInfos.size());
+        devInfo.pQueueCreateInfos = queueInfos.data();
         devInfo.enabledExtensionCount = 2; // Now we have 2 extensions
         devInfo.ppEnabledExtensionNames = deviceExtensions;
 
@@ -295,6 +332,22 @@ Engine {
 
         vk::Queue queue = mVkDevice.get().getQueue(0, 0);
         mVkQueue = vk::SharedQueue(queue, mVkDevice);
+
+        if (mTransferQueueFamily) {
+            mVkTransferQueue = vk::SharedQueue(mVkDevice.get().getQueue(*mTransferQueueFamily, 0), mVkDevice);
+        }
+    }
+
+    void Application::CreatePipelineCache(const WindowCreationInfo &info) {
+        std::filesystem::path directory = std::filesystem::temp_directory_path();
+        if (char *prefPath = SDL_GetPrefPath("Frosty", info.Title)) {
+            directory = std::filesystem::path(reinterpret_cast<const char8_t *>(prefPath));
+            SDL_free(prefPath);
+        }
+
+        mPipelineCache = std::make_unique<PipelineCache>(mVkPhysicalDevice, mVkDevice, directory);
+        // nvrhi creates its pipelines through the default dispatcher, this is how they end up in the cache
+        mPipelineCache->Install();
     }
 
     void Application::InitNVRHI() {
@@ -316,6 +369,10 @@ Engine {
         nvrhiDesc.device = mVkDevice.get();
         nvrhiDesc.graphicsQueue = mVkQueue.get();
         nvrhiDesc.graphicsQueueIndex = 0;
+        if (mVkTransferQueue) {
+            nvrhiDesc.transferQueue = mVkTransferQueue.get();
+            nvrhiDesc.transferQueueIndex = static_cast<int>(*mTransferQueueFamily);
+        }
         nvrhiDesc.deviceExtensions = deviceExtensions;
         nvrhiDesc.numDeviceExtensions = 2;
 
@@ -353,42 +410,24 @@ Engine {
     }
 
     void Application::RecreateSwapchain() {
-        // Wait for all in-flight frames to complete
-        std::vector<vk::Fence> fencesToWait;
-        for (uint32_t i = 0; i < MaxFramesInFlight; ++i) {
-            fencesToWait.push_back(mRenderCompleteFences[i].get());
-        }
-
-        vk::Result waitResult = mVkDevice.get().waitForFences(
-            fencesToWait,
-            vk::True,
-            UINT64_MAX
-        );
-
-        if (waitResult != vk::Result::eSuccess) {
-            throw Engine::RuntimeException("Failed to wait for fences during swapchain recreation");
-        }
-
-        // Use PlatformSwapchain's Recreate method (handles old swapchain internally)
-        mSwapchain.Recreate(
-            mWindow.get(),
-            mVkSurface,
-            mVkPhysicalDevice,
-            mVkDevice,
-            mNvrhiDevice
-        );
-
-        // Clear and recreate acquire semaphores per frame in flight
-        mAcquireSemaphores.clear();
-        mAcquireSemaphores.resize(MaxFramesInFlight);
-        vk::SemaphoreCreateInfo semaphoreInfo;
-        for (uint32_t i = 0; i < MaxFramesInFlight; ++i) {
-            vk::Semaphore acquireSem = mVkDevice.get().createSemaphore(semaphoreInfo);
-            mAcquireSemaphores[i] = vk::SharedSemaphore(acquireSem, mVkDevice);
-        }
+        const auto start = std::chrono::steady_clock::now();
+
+        // Frames in flight keep rendering to and presenting the old images. The first frame submitted from now on
+        // uses the new swapchain, once it has completed the old one is no longer presenting.
+        mRetiredSwapchains.push_back({
+            .Swapchain = mSwapchain.Recreate(mWindow.get(), mVkSurface, mVkPhysicalDevice, mVkDevice, mNvrhiDevice),
+            .RetiredFrame = mSubmittedFrameCount
+        });
+
+        // Acquire semaphores are left unsignaled by every path through RenderFrame, so they are reused as they are
+
+        const std::chrono::duration<float, std::milli> hitch = std::chrono::steady_clock::now() - start;
+        ++mResizeStatistics.SwapchainRecreations;
+        mResizeStatistics.RetiredSwapchains = static_cast<uint32_t>(mRetiredSwapchains.size());
+        mResizeStatistics.LastHitch = hitch;
+        mResizeStatistics.MaxHitch = std::max(mResizeStatistics.MaxHitch, hitch);
     }
 
-
     void Application::ExecuteDeferredTasks() {
         for (auto &task: mDeferredTasks) {
             std::invoke(std::move(task));
@@ -396,6 +435,21 @@ Engine {
         mDeferredTasks.clear();
     }
 
+    void Application::ReportPipelineCreation() const {
+        if (!mPipelineCache) {
+            return;
+        }
+
+        const PipelineCacheStatistics statistics = mPipelineCache->GetStatistics();
+        std::cout << "Pipeline creation: " << statistics.PipelineCount << " pipelines in "
+                << statistics.CreationTime.count() << " ms, ";
+        if (statistics.LoadedBytes > 0) {
+            std::cout << "warm cache (" << statistics.LoadedBytes << " bytes loaded)" << std::endl;
+        } else {
+            std::cout << "cold cache" << std::endl;
+        }
+    }
+
     void Application::ProcessEvents() {
         SDL_Event event;
         while (SDL_PollEvent(&event)) {
@@ -443,15 +497,27 @@ Engine {
             throw Engine::RuntimeException("Failed to wait for render complete fence");
         }
 
+        // The fence covers frame mSubmittedFrameCount - MaxFramesInFlight and, in queue order, every frame before it
+        const uint64_t completedFrames = mSubmittedFrameCount + 1 -
+                                         std::min<uint64_t>(mSubmittedFrameCount + 1, MaxFramesInFlight);
+        std::erase_if(mRetiredSwapchains, [&](const RetiredSwapchain &retired) {
+            return retired.RetiredFrame < completedFrames;
+        });
+        mResizeStatistics.RetiredSwapchains = static_cast<uint32_t>(mRetiredSwapchains.size());
+
         // Use per-frame acquire semaphore
         vk::SharedSemaphore &frameAcquireSemaphore = mAcquireSemaphores[mCurrentFrameIndex];
 
         // Acquire next swapchain image using new API
         SwapchainAcquireResult acquireResult = mSwapchain.AcquireNextImage(frameAcquireSemaphore.get());
 
+        // Nothing was acquired when out of date, the semaphore stays unsignaled. A suboptimal image still has to be
+        // rendered and presented, or its acquire semaphore would stay signaled into the next use.
         if (acquireResult.NeedsRecreation()) {
             mNeedsResize = true;
-            return;
+            if (!acquireResult.IsValid()) {
+                return;
+            }
         }
 
         if (!acquireResult.IsSuccess() && !acquireResult.IsValid()) {
@@ -470,6 +536,8 @@ Engine {
 
         mCommandList->open();
 
+        mTextureUploader->Process(mCommandList);
+
         const nvrhi::FramebufferHandle &currentFramebuffer = mSwapchain.GetFramebuffer(imageIndex);
 
         nvrhi::ITexture *currentBackBuffer = mSwapchain.GetBackBuffer(imageIndex);
@@ -480,6 +548,13 @@ Engine {
             GetClearColor()
         );
 
+        mFrameGraph->Reset();
+        const FrameGraphTexture backBuffer = mFrameGraph->Import(currentBackBuffer);
+        for (auto &layer: mLayers) {
+            layer->OnBuildFrameGraph(*mFrameGraph, backBuffer);
+        }
+        mFrameGraph->Execute(mCommandList);
+
         mCommandList->setResourceStatesForFramebuffer(currentFramebuffer);
         mCommandList->commitBarriers();
 
@@ -505,6 +580,7 @@ Engine {
         }
 
         mCurrentFrameIndex = (mCurrentFrameIndex + 1) % MaxFramesInFlight;
+        ++mSubmittedFrameCount;
     }
 
     void Application::OnRender(const nvrhi::CommandListHandle &commandList,
@@ -6,6 +6,9 @@ import Render.Color;
 import Core.Layer;
 import Core.Events;
 import Render.Swapchain;
+import Render.PipelineCache;
+import Render.FrameGraph;
+import Render.TextureUploader;
 import "SDL3/SDL.h";
 import "SDL3/SDL_video.h";
 
@@ -29,6 +32,10 @@ Engine {
                               const nvrhi::FramebufferHandle &framebuffer,
                               uint32_t frameIndex) {}
 
+        // Declares this layer's off-screen passes for the frame, before any layer's OnRender runs. backBuffer is
+        // the imported swapchain image, already cleared.
+        virtual void OnBuildFrameGraph(FrameGraph &graph, FrameGraphTexture backBuffer) {}
+
         virtual void OnFrameEnded(std::function<void()> callback);
 
         template<typename T>
@@ -54,6 +61,15 @@ Engine {
         uint32_t SDLWindowFlags = SDL_WINDOW_RESIZABLE;
     };
 
+    // Window resizes are coalesced into at most one swapchain recreation per frame. The previous swapchain is
+    // retired instead of idling the device, hitches are the main thread time spent recreating.
+    export struct ResizeStatistics {
+        uint32_t SwapchainRecreations = 0;
+        uint32_t RetiredSwapchains = 0;  // Still waiting for the frames that used them
+        std::chrono::duration<float, std::milli> LastHitch{};
+        std::chrono::duration<float, std::milli> MaxHitch{};
+    };
+
     // Application class with all inline implementations
     class Application : public std::enable_shared_from_this<Application> {
     public:
@@ -80,7 +96,17 @@ Engine {
         [[nodiscard]] const nvrhi::vulkan::DeviceHandle &GetNvrhiDevice() const { return mNvrhiDevice; }
         [[nodiscard]] const nvrhi::CommandListHandle &GetCommandList() const { return mCommandList; }
 
+        // Shared by every pipeline the application creates, see PipelineCache
+        [[nodiscard]] const std::unique_ptr<PipelineCache> &GetPipelineCache() const { return mPipelineCache; }
+
+        // Rebuilt every frame from Layer::OnBuildFrameGraph, statistics describe the last executed frame
+        [[nodiscard]] const std::unique_ptr<FrameGraph> &GetFrameGraph() const { return mFrameGraph; }
+
+        // Uploads queued from any thread are recorded at the start of each frame, within its byte budget
+        [[nodiscard]] const std::unique_ptr<TextureUploader> &GetTextureUploader() const { return mTextureUploader; }
+
         [[nodiscard]] const PlatformSwapchain &GetSwapchain() const { return mSwapchain; }
+        [[nodiscard]] const ResizeStatistics &GetResizeStatistics() const { return mResizeStatistics; }
 
         // Legacy compatibility - maps to new Swapchain API
         [[nodiscard]] const PlatformSwapchain &GetSwapchainData() const { return mSwapchain; }
@@ -145,6 +171,8 @@ Engine {
 
         void CreateLogicalDevice();
 
+        void CreatePipelineCache(const WindowCreationInfo &info);
+
         void InitNVRHI();
 
         void CreateSwapchain();
@@ -157,6 +185,8 @@ Engine {
 
         void ProcessEvents();
 
+        void ReportPipelineCreation() const;
+
     public:
         virtual void OnPostRender();
 
@@ -180,19 +210,34 @@ Engine {
         vk::SharedSurfaceKHR mVkSurface;
         vk::SharedDevice mVkDevice;
         vk::SharedQueue mVkQueue;
+        vk::SharedQueue mVkTransferQueue; // Null without a dedicated transfer family
+        std::optional<uint32_t> mTransferQueueFamily;
+        std::unique_ptr<PipelineCache> mPipelineCache;
 
         // NVRHI
         std::shared_ptr<NvrhiMessageCallback> mMessageCallback;
         nvrhi::vulkan::DeviceHandle mNvrhiDevice;
         nvrhi::CommandListHandle mCommandList;
+        std::unique_ptr<FrameGraph> mFrameGraph;
+        std::unique_ptr<TextureUploader> mTextureUploader;
 
         // Swapchain (uses new PlatformSwapchain class)
         PlatformSwapchain mSwapchain;
 
+        // Swapchains replaced by RecreateSwapchain, destroyed once the frame numbered RetiredFrame has completed
+        struct RetiredSwapchain {
+            PlatformSwapchain Swapchain;
+            uint64_t RetiredFrame;
+        };
+
+        std::vector<RetiredSwapchain> mRetiredSwapchains;
+        ResizeStatistics mResizeStatistics;
+
         // Frame-in-flight synchronization (separate from swapchain)
         std::vector<vk::SharedSemaphore> mAcquireSemaphores; // Per-frame (for acquire)
         std::array<vk::SharedFence, MaxFrameInFlight> mRenderCompleteFences;
         uint32_t mCurrentFrameIndex = 0;
+        uint64_t mSubmittedFrameCount = 0;
 
         // probably you should never use this
         uint32_t mCurrentImageIndex = 0;
@@ -201,6 +246,7 @@ Engine {
         bool mRunning = false;
         bool mNeedsResize = false;
         bool mMinimized = false;
+        bool mPipelineCreationReported = false;
 
         // time
         std::chrono::steady_clock::time_point mLastFrameTimestamp;
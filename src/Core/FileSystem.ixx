@@ -29,4 +29,87 @@ Engine {
 
         return future;
     }
+
+    // Read-only view of a whole file through the OS page cache, nothing is copied until the bytes are touched
+    export class MappedFile {
+    public:
+        MappedFile() = default;
+
+        explicit MappedFile(const std::filesystem::path &path) {
+            mFile = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+            if (mFile == INVALID_HANDLE_VALUE) {
+                throw Engine::RuntimeException("MappedFile: Failed to open " + path.string() + ".");
+            }
+
+            LARGE_INTEGER size;
+            if (!GetFileSizeEx(mFile, &size)) {
+                Close();
+                throw Engine::RuntimeException("MappedFile: Failed to query the size of " + path.string() + ".");
+            }
+            mSize = static_cast<size_t>(size.QuadPart);
+
+            // Empty files cannot be mapped, they are simply an empty view
+            if (mSize == 0) {
+                return;
+            }
+
+            mMapping = CreateFileMappingW(mFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (mMapping) {
+                mData = static_cast<const uint8_t *>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+            }
+            if (!mData) {
+                Close();
+                throw Engine::RuntimeException("MappedFile: Failed to map " + path.string() + ".");
+            }
+        }
+
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+
+        MappedFile(MappedFile &&other) noexcept {
+            *this = std::move(other);
+        }
+
+        MappedFile &operator=(MappedFile &&other) noexcept {
+            if (this != &other) {
+                Close();
+                mFile = std::exchange(other.mFile, INVALID_HANDLE_VALUE);
+                mMapping = std::exchange(other.mMapping, nullptr);
+                mData = std::exchange(other.mData, nullptr);
+                mSize = std::exchange(other.mSize, 0);
+            }
+            return *this;
+        }
+
+        ~MappedFile() {
+            Close();
+        }
+
+        [[nodiscard]] std::span<const uint8_t> GetData() const {
+            return {mData, mData ? mSize : 0};
+        }
+
+    private:
+        void Close() {
+            if (mData) {
+                UnmapViewOfFile(mData);
+                mData = nullptr;
+            }
+            if (mMapping) {
+                CloseHandle(mMapping);
+                mMapping = nullptr;
+            }
+            if (mFile != INVALID_HANDLE_VALUE) {
+                CloseHandle(mFile);
+                mFile = INVALID_HANDLE_VALUE;
+            }
+            mSize = 0;
+        }
+
+        HANDLE mFile = INVALID_HANDLE_VALUE;
+        HANDLE mMapping = nullptr;
+        const uint8_t *mData = nullptr;
+        size_t mSize = 0;
+    };
 }
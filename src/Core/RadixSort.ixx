@@ -0,0 +1,61 @@
+export module Core.RadixSort;
+
+import Core.Prelude;
+
+namespace
+Engine {
+    // Packed ordering key plus the index of the element it orders
+    export struct SortKey {
+        uint64_t Key;
+        uint32_t Payload;
+    };
+
+    // Stable LSD radix sort on 8-bit digits. Keys that compare equal keep their relative order.
+    // Digits shared by every key are skipped, so narrow key ranges only cost one or two passes.
+    export void RadixSort(std::vector<SortKey> &keys, std::vector<SortKey> &scratch) {
+        constexpr size_t DigitCount = sizeof(uint64_t);
+        constexpr size_t BucketCount = 256;
+
+        if (keys.size() < 2) {
+            return;
+        }
+
+        std::array<std::array<uint32_t, BucketCount>, DigitCount> histograms{};
+        for (const auto &key: keys) {
+            for (size_t digit = 0; digit < DigitCount; ++digit) {
+                ++histograms[digit][(key.Key >> (digit * 8)) & 0xFF];
+            }
+        }
+
+        scratch.resize(keys.size());
+
+        std::vector<SortKey> *source = &keys;
+        std::vector<SortKey> *destination = &scratch;
+
+        for (size_t digit = 0; digit < DigitCount; ++digit) {
+            auto &histogram = histograms[digit];
+            const size_t shift = digit * 8;
+
+            if (histogram[((*source)[0].Key >> shift) & 0xFF] == source->size()) {
+                continue;
+            }
+
+            uint32_t offset = 0;
+            for (auto &count: histogram) {
+                uint32_t bucketSize = count;
+                count = offset;
+                offset += bucketSize;
+            }
+
+            for (const auto &key: *source) {
+                (*destination)[histogram[(key.Key >> shift) & 0xFF]++] = key;
+            }
+
+            std::swap(source, destination);
+        }
+
+        if (source != &keys) {
+            keys.swap(scratch);
+        }
+    }
+}
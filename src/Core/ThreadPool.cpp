@@ -0,0 +1,84 @@
+module Core.ThreadPool;
+
+import Core.Prelude;
+
+namespace
+Engine {
+    ThreadPool::ThreadPool(uint32_t workerCount) {
+        mWorkers.reserve(workerCount);
+        for (uint32_t i = 0; i < workerCount; ++i) {
+            mWorkers.emplace_back([this](std::stop_token stopToken) { WorkerLoop(std::move(stopToken)); });
+        }
+    }
+
+    uint32_t ThreadPool::GetWorkerCount() const {
+        return static_cast<uint32_t>(mWorkers.size());
+    }
+
+    void ThreadPool::ParallelForChunks(size_t count, size_t chunkSize,
+                                       const std::function<void(size_t begin, size_t end)> &function) {
+        chunkSize = std::max<size_t>(1, chunkSize);
+        const size_t chunkCount = (count + chunkSize - 1) / chunkSize;
+
+        if (chunkCount <= 1 || mWorkers.empty()) {
+            for (size_t begin = 0; begin < count; begin += chunkSize) {
+                function(begin, std::min(begin + chunkSize, count));
+            }
+            return;
+        }
+
+        std::atomic<size_t> nextChunk = 0;
+        auto runChunks = [&] {
+            for (size_t chunk = nextChunk++; chunk < chunkCount; chunk = nextChunk++) {
+                const size_t begin = chunk * chunkSize;
+                function(begin, std::min(begin + chunkSize, count));
+            }
+        };
+
+        // Helpers reference this stack frame, so wait for every one of them, including those that start after
+        // all chunks were taken
+        const auto helperCount = static_cast<ptrdiff_t>(std::min<size_t>(mWorkers.size(), chunkCount - 1));
+        std::latch helpersDone(helperCount);
+        {
+            std::lock_guard lock(mMutex);
+            for (ptrdiff_t i = 0; i < helperCount; ++i) {
+                mTasks.emplace_back([&] {
+                    runChunks();
+                    helpersDone.count_down();
+                });
+            }
+        }
+        mWakeUp.notify_all();
+
+        runChunks();
+        helpersDone.wait();
+    }
+
+    void ThreadPool::Submit(std::function<void()> task) {
+        if (mWorkers.empty()) {
+            task();
+            return;
+        }
+
+        {
+            std::lock_guard lock(mMutex);
+            mTasks.push_back(std::move(task));
+        }
+        mWakeUp.notify_one();
+    }
+
+    void ThreadPool::WorkerLoop(std::stop_token stopToken) {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock lock(mMutex);
+                if (!mWakeUp.wait(lock, stopToken, [this] { return !mTasks.empty(); })) {
+                    return;
+                }
+                task = std::move(mTasks.front());
+                mTasks.pop_front();
+            }
+            task();
+        }
+    }
+}
@@ -0,0 +1,37 @@
+export module Core.ThreadPool;
+
+import Core.Prelude;
+
+namespace
+Engine {
+    // Fixed set of worker threads for fork-join work. The calling thread always takes part, so a pool without
+    // workers runs everything inline.
+    export class ThreadPool {
+    public:
+        explicit ThreadPool(uint32_t workerCount);
+
+        ThreadPool(const ThreadPool &) = delete;
+
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        [[nodiscard]] uint32_t GetWorkerCount() const;
+
+        // Calls function(begin, end) for consecutive chunks of [0, count) holding at most chunkSize elements and
+        // returns once all of them finished. Chunks may run in any order and on any thread, so they must not
+        // depend on each other. function must not throw.
+        void ParallelForChunks(size_t count, size_t chunkSize,
+                               const std::function<void(size_t begin, size_t end)> &function);
+
+        // Runs task on a worker without waiting for it, or inline if the pool has no workers. Tasks start in
+        // submission order, as many at a time as there are workers.
+        void Submit(std::function<void()> task);
+
+    private:
+        void WorkerLoop(std::stop_token stopToken);
+
+        std::mutex mMutex;
+        std::condition_variable_any mWakeUp;
+        std::deque<std::function<void()>> mTasks;
+        std::vector<std::jthread> mWorkers;  // Last member, the workers are stopped and joined first
+    };
+}
@@ -0,0 +1,144 @@
+export module Core.UniformGrid;
+
+import Core.Prelude;
+
+namespace
+Engine {
+    // Spatial index for retained 2D content that is mostly static, such as tiles or props of a large world.
+    // Items are bucketed into every cell their bounds overlap, so a query only touches the cells the query
+    // rectangle overlaps. Items spanning more than MaxCellsPerItem cells, such as backgrounds, are kept in a
+    // separate list that every query tests instead. Queries cost about the number of items near the rectangle
+    // plus the number of large items, instead of the number of items in the grid.
+    export template<typename T>
+    class UniformGrid {
+    public:
+        static constexpr uint64_t MaxCellsPerItem = 16;
+
+        explicit UniformGrid(float cellSize) : mCellSize(cellSize) {
+            if (!(cellSize > 0.0f)) {
+                throw Engine::RuntimeException("UniformGrid: Cell size must be positive.");
+            }
+        }
+
+        // bounds is (min x, min y, max x, max y), returns the item's index
+        uint32_t Insert(const glm::vec4 &bounds, T item) {
+            const auto index = static_cast<uint32_t>(mItems.size());
+            mItems.push_back({bounds, std::move(item)});
+
+            const int32_t minX = CellCoordinate(bounds.x);
+            const int32_t minY = CellCoordinate(bounds.y);
+            const int32_t maxX = CellCoordinate(bounds.z);
+            const int32_t maxY = CellCoordinate(bounds.w);
+            if (CellCount(minX, minY, maxX, maxY) > MaxCellsPerItem) {
+                mLargeItems.push_back(index);
+                return index;
+            }
+
+            for (int32_t y = minY; y <= maxY; ++y) {
+                for (int32_t x = minX; x <= maxX; ++x) {
+                    mCells[CellKey(x, y)].push_back(index);
+                }
+            }
+            return index;
+        }
+
+        void Clear() {
+            mItems.clear();
+            mCells.clear();
+            mLargeItems.clear();
+        }
+
+        [[nodiscard]] size_t Size() const {
+            return mItems.size();
+        }
+
+        [[nodiscard]] const T &GetItem(uint32_t index) const {
+            return mItems[index].Item;
+        }
+
+        [[nodiscard]] const glm::vec4 &GetBounds(uint32_t index) const {
+            return mItems[index].Bounds;
+        }
+
+        // Replaces indices with the items whose bounds overlap bounds, in insertion order so that drawing the
+        // result is deterministic
+        void Query(const glm::vec4 &bounds, std::vector<uint32_t> &indices) const {
+            indices.clear();
+            if (mItems.empty()) {
+                return;
+            }
+
+            const int32_t minX = CellCoordinate(bounds.x);
+            const int32_t minY = CellCoordinate(bounds.y);
+            const int32_t maxX = CellCoordinate(bounds.z);
+            const int32_t maxY = CellCoordinate(bounds.w);
+
+            // Sparse grids are cheaper to scan through the occupied cells than through the covered ones
+            if (CellCount(minX, minY, maxX, maxY) > mCells.size()) {
+                for (const auto &[key, cell]: mCells) {
+                    const int32_t x = static_cast<int32_t>(key >> 32);
+                    const int32_t y = static_cast<int32_t>(key & 0xFFFFFFFF);
+                    if (x >= minX && x <= maxX && y >= minY && y <= maxY) {
+                        AppendOverlapping(cell, bounds, indices);
+                    }
+                }
+            } else {
+                for (int32_t y = minY; y <= maxY; ++y) {
+                    for (int32_t x = minX; x <= maxX; ++x) {
+                        if (auto it = mCells.find(CellKey(x, y)); it != mCells.end()) {
+                            AppendOverlapping(it->second, bounds, indices);
+                        }
+                    }
+                }
+            }
+
+            AppendOverlapping(mLargeItems, bounds, indices);
+
+            // Items spanning several cells were found once per overlapped cell
+            std::ranges::sort(indices);
+            indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+        }
+
+    private:
+        struct Entry {
+            glm::vec4 Bounds;
+            T Item;
+        };
+
+        // Clamped well inside int32_t, so far away positions and tiny cells neither overflow the conversion nor
+        // the loops over cell ranges
+        [[nodiscard]] int32_t CellCoordinate(float position) const {
+            constexpr float limit = static_cast<float>(1 << 30);
+            return static_cast<int32_t>(std::clamp(std::floor(position / mCellSize), -limit, limit));
+        }
+
+        // Cells in the inclusive range, empty ranges count as none
+        [[nodiscard]] static uint64_t CellCount(int32_t minX, int32_t minY, int32_t maxX, int32_t maxY) {
+            if (maxX < minX || maxY < minY) {
+                return 0;
+            }
+            return static_cast<uint64_t>(static_cast<int64_t>(maxX) - minX + 1) *
+                   static_cast<uint64_t>(static_cast<int64_t>(maxY) - minY + 1);
+        }
+
+        [[nodiscard]] static uint64_t CellKey(int32_t x, int32_t y) {
+            return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
+        }
+
+        void AppendOverlapping(const std::vector<uint32_t> &cell, const glm::vec4 &bounds,
+                               std::vector<uint32_t> &indices) const {
+            for (uint32_t index: cell) {
+                const glm::vec4 &itemBounds = mItems[index].Bounds;
+                if (itemBounds.x <= bounds.z && itemBounds.y <= bounds.w &&
+                    itemBounds.z >= bounds.x && itemBounds.w >= bounds.y) {
+                    indices.push_back(index);
+                }
+            }
+        }
+
+        float mCellSize;
+        std::vector<Entry> mItems;
+        std::unordered_map<uint64_t, std::vector<uint32_t>> mCells;
+        std::vector<uint32_t> mLargeItems;  // Spanning more than MaxCellsPerItem cells, tested by every query
+    };
+}
@@ -48,7 +48,7 @@ Engine {
         init_info.Device = mVkDevice.get();
         init_info.QueueFamily = ImGui_ImplVulkanH_SelectQueueFamilyIndex(mVkPhysicalDevice.get());
         init_info.Queue = mVkQueue.get();
-        init_info.PipelineCache = nullptr;
+        init_info.PipelineCache = mPipelineCache->Get();
         init_info.DescriptorPool = VK_NULL_HANDLE; // No longer needed - ImGui manages internally
         init_info.DescriptorPoolSize = 0; // No longer needed - ImGui manages internally
         // MinImageCount should be the minimum swapchain images
@@ -76,6 +76,11 @@ Engine {
         VkDevice vkDevice = mVkDevice.get();
         ImGui_ImplVulkan_LoadFunctions(vk::ApiVersion12, [](const char *function_name, void *user_data) {
             VkDevice device = *static_cast<VkDevice *>(user_data);
+            // Go through the dispatcher so ImGui's pipeline creation is timed along with everyone else's
+            if (std::string_view(function_name) == "vkCreateGraphicsPipelines") {
+                return reinterpret_cast<PFN_vkVoidFunction>(
+                    vk::detail::defaultDispatchLoaderDynamic.vkCreateGraphicsPipelines);
+            }
             // First try device-level functions (for commands like vkCmdBeginRenderingKHR)
             PFN_vkVoidFunction func = vkGetDeviceProcAddr(device, function_name);
             return func;
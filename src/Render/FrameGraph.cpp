@@ -0,0 +1,354 @@
+module Render.FrameGraph;
+
+import Vendor.ApplicationAPI;
+import Core.Prelude;
+
+namespace Engine {
+    namespace {
+        // Framebuffers of imported textures change with every back buffer, bounds the cache between rebuilds
+        constexpr size_t MaxCachedFramebuffers = 64;
+
+        uint64_t AlignUp(uint64_t value, uint64_t alignment) {
+            return alignment > 1 ? (value + alignment - 1) / alignment * alignment : value;
+        }
+
+        bool IsDepthFormat(nvrhi::Format format) {
+            return nvrhi::getFormatInfo(format).hasDepth;
+        }
+
+        nvrhi::ResourceStates WriteState(nvrhi::Format format) {
+            return IsDepthFormat(format) ? nvrhi::ResourceStates::DepthWrite : nvrhi::ResourceStates::RenderTarget;
+        }
+    }
+
+    FrameGraphTexture FrameGraphPassBuilder::Create(const FrameGraphTextureDesc &desc) {
+        if (desc.Width == 0 || desc.Height == 0) {
+            throw Engine::RuntimeException("FrameGraph: Transient textures must not be empty.");
+        }
+
+        return Write({mGraph.AddResource({.Desc = desc})});
+    }
+
+    FrameGraphTexture FrameGraphPassBuilder::Read(FrameGraphTexture texture) {
+        if (texture.Index >= mGraph.mResources.size()) {
+            throw Engine::RuntimeException("FrameGraph: Pass reads an unknown texture.");
+        }
+
+        mGraph.mPasses[mPass].Reads.push_back(texture.Index);
+        return texture;
+    }
+
+    FrameGraphTexture FrameGraphPassBuilder::Write(FrameGraphTexture texture) {
+        if (texture.Index >= mGraph.mResources.size()) {
+            throw Engine::RuntimeException("FrameGraph: Pass writes an unknown texture.");
+        }
+
+        mGraph.mPasses[mPass].Writes.push_back(texture.Index);
+        return texture;
+    }
+
+    void FrameGraphPassBuilder::SetSideEffect() {
+        mGraph.mPasses[mPass].SideEffect = true;
+    }
+
+    nvrhi::ITexture *FrameGraphPassContext::GetTexture(FrameGraphTexture texture) const {
+        return mGraph.GetTexture(texture);
+    }
+
+    FrameGraph::FrameGraph(nvrhi::IDevice *device) : mDevice(device) {}
+
+    void FrameGraph::Reset() {
+        mPasses.clear();
+        mResources.clear();
+    }
+
+    FrameGraphTexture FrameGraph::Import(nvrhi::ITexture *texture) {
+        if (!texture) {
+            throw Engine::RuntimeException("FrameGraph: Cannot import a null texture.");
+        }
+
+        const auto &desc = texture->getDesc();
+        return {AddResource({.Imported = texture, .Desc = {.Width = desc.width, .Height = desc.height,
+                                                            .Format = desc.format}})};
+    }
+
+    void FrameGraph::AddPass(std::string_view name, const SetupCallback &setup, ExecuteCallback execute) {
+        const auto index = static_cast<uint32_t>(mPasses.size());
+        mPasses.push_back({.Name = std::string(name), .Execute = std::move(execute)});
+
+        FrameGraphPassBuilder builder(*this, index);
+        setup(builder);
+    }
+
+    void FrameGraph::Execute(nvrhi::ICommandList *commandList) {
+        mStatistics = {};
+        mStatistics.Passes = static_cast<uint32_t>(mPasses.size());
+
+        CullPasses();
+        PlaceTransients();
+
+        // Transients continue from the state the graph left them in at the end of last frame, so their first
+        // barrier this frame waits for last frame's accesses. Only freshly placed ones start out Unknown.
+        for (const auto &transient: mTransients) {
+            commandList->beginTrackingTextureState(transient.Texture, nvrhi::AllSubresources, transient.State);
+        }
+
+        auto transition = [&](uint32_t resource, nvrhi::ResourceStates state) {
+            commandList->setTextureState(GetTexture({resource}), nvrhi::AllSubresources, state);
+            if (!mResources[resource].Imported) {
+                mTransients[mResources[resource].Transient].State = state;
+            }
+        };
+
+        for (uint32_t i = 0; i < mPasses.size(); ++i) {
+            const Pass &pass = mPasses[i];
+            if (!pass.Kept) {
+                ++mStatistics.CulledPasses;
+                continue;
+            }
+
+            // Transients whose lifetime starts here take over memory that aliasing transients may have accessed,
+            // earlier this frame or, for those used later, in the previous frame. nvrhi has no aliasing barrier,
+            // so those are moved to CopyDest, a state valid for color and depth images alike. That orders their
+            // last accesses before the transfer stage of the new texture's clear.
+            bool handedOver = false;
+            for (const auto &transient: mTransients) {
+                if (transient.FirstPass != i) {
+                    continue;
+                }
+                for (uint32_t alias: transient.Aliases) {
+                    commandList->setTextureState(mTransients[alias].Texture, nvrhi::AllSubresources,
+                                                 nvrhi::ResourceStates::CopyDest);
+                    mTransients[alias].State = nvrhi::ResourceStates::CopyDest;
+                    handedOver = true;
+                }
+            }
+            if (handedOver) {
+                commandList->commitBarriers();
+            }
+
+            for (auto &transient: mTransients) {
+                if (transient.FirstPass != i) {
+                    continue;
+                }
+                if (IsDepthFormat(transient.Desc.Format)) {
+                    commandList->clearDepthStencilTexture(transient.Texture, nvrhi::AllSubresources, true, 1.0f,
+                                                          nvrhi::getFormatInfo(transient.Desc.Format).hasStencil,
+                                                          0);
+                } else {
+                    commandList->clearTextureFloat(transient.Texture, nvrhi::AllSubresources,
+                                                   transient.Desc.ClearColor);
+                }
+                transient.State = nvrhi::ResourceStates::CopyDest;
+            }
+
+            // One batch of barriers per pass, covering everything it declared
+            for (uint32_t read: pass.Reads) {
+                transition(read, nvrhi::ResourceStates::ShaderResource);
+            }
+            for (uint32_t write: pass.Writes) {
+                transition(write, WriteState(mResources[write].Desc.Format));
+            }
+            commandList->commitBarriers();
+
+            FrameGraphPassContext context(*this, commandList, GetPassFramebuffer(pass));
+            commandList->beginMarker(pass.Name.c_str());
+            pass.Execute(context);
+            commandList->endMarker();
+        }
+    }
+
+    nvrhi::ITexture *FrameGraph::GetTexture(FrameGraphTexture texture) const {
+        if (texture.Index >= mResources.size()) {
+            return nullptr;
+        }
+
+        const Resource &resource = mResources[texture.Index];
+        if (resource.Imported) {
+            return resource.Imported;
+        }
+        return resource.Transient < mTransients.size() ? mTransients[resource.Transient].Texture.Get() : nullptr;
+    }
+
+    uint32_t FrameGraph::AddResource(Resource resource) {
+        mResources.push_back(resource);
+        return static_cast<uint32_t>(mResources.size() - 1);
+    }
+
+    void FrameGraph::CullPasses() {
+        // Walking backwards, a pass is needed if it writes something already known to be needed. Its reads
+        // become needed in turn.
+        std::vector<bool> needed(mResources.size(), false);
+        for (size_t i = 0; i < mResources.size(); ++i) {
+            needed[i] = mResources[i].Imported != nullptr;
+        }
+
+        for (auto &pass: mPasses | std::views::reverse) {
+            pass.Kept = pass.SideEffect || std::ranges::any_of(pass.Writes, [&](uint32_t write) {
+                return needed[write];
+            });
+            if (pass.Kept) {
+                for (uint32_t read: pass.Reads) {
+                    needed[read] = true;
+                }
+            }
+        }
+    }
+
+    void FrameGraph::PlaceTransients() {
+        mPlannedTransients.clear();
+        for (auto &resource: mResources) {
+            resource.Transient = FrameGraphTexture::InvalidIndex;
+        }
+
+        for (uint32_t i = 0; i < mPasses.size(); ++i) {
+            if (!mPasses[i].Kept) {
+                continue;
+            }
+
+            auto use = [&](uint32_t index) {
+                Resource &resource = mResources[index];
+                if (resource.Imported) {
+                    return;
+                }
+                if (resource.Transient == FrameGraphTexture::InvalidIndex) {
+                    resource.Transient = static_cast<uint32_t>(mPlannedTransients.size());
+                    mPlannedTransients.push_back({.Desc = resource.Desc, .FirstPass = i, .LastPass = i});
+                }
+                mPlannedTransients[resource.Transient].LastPass = i;
+            };
+            std::ranges::for_each(mPasses[i].Reads, use);
+            std::ranges::for_each(mPasses[i].Writes, use);
+        }
+
+        if (mPlannedTransients == mTransients) {
+            // Same textures and lifetimes as last frame, only the clear colors may differ
+            for (size_t i = 0; i < mTransients.size(); ++i) {
+                mTransients[i].Desc = mPlannedTransients[i].Desc;
+            }
+        } else {
+            mFramebuffers.clear();
+            mStatistics.TransientRebuilds = 1;
+
+            std::vector<uint64_t> alignments;
+            for (auto &transient: mPlannedTransients) {
+                const bool depth = IsDepthFormat(transient.Desc.Format);
+
+                nvrhi::TextureDesc desc;
+                desc.width = transient.Desc.Width;
+                desc.height = transient.Desc.Height;
+                desc.format = transient.Desc.Format;
+                desc.isRenderTarget = true;
+                desc.isShaderResource = true;
+                desc.isVirtual = true;
+                desc.useClearValue = true;
+                desc.clearValue = depth ? nvrhi::Color(1.0f, 0.0f, 0.0f, 0.0f) : transient.Desc.ClearColor;
+                desc.debugName = transient.Desc.DebugName;
+                transient.Texture = mDevice->createTexture(desc);
+
+                const nvrhi::MemoryRequirements requirements = mDevice->getTextureMemoryRequirements(
+                    transient.Texture);
+                transient.Size = requirements.size;
+                alignments.push_back(requirements.alignment);
+            }
+
+            // Largest first, each at the lowest offset that no transient alive at the same time occupies
+            std::vector<uint32_t> order(mPlannedTransients.size());
+            std::iota(order.begin(), order.end(), 0u);
+            std::ranges::stable_sort(order, std::greater{}, [&](uint32_t i) {
+                return mPlannedTransients[i].Size;
+            });
+
+            uint64_t heapSize = 0;
+            std::vector<uint32_t> placed;
+            for (uint32_t i: order) {
+                Transient &transient = mPlannedTransients[i];
+                auto overlapsInTime = [&](const Transient &other) {
+                    return other.FirstPass <= transient.LastPass && transient.FirstPass <= other.LastPass;
+                };
+
+                uint64_t offset = 0;
+                for (bool moved = true; moved;) {
+                    moved = false;
+                    for (uint32_t j: placed) {
+                        const Transient &other = mPlannedTransients[j];
+                        if (overlapsInTime(other) && offset < other.Offset + other.Size &&
+                            other.Offset < offset + transient.Size) {
+                            offset = AlignUp(other.Offset + other.Size, alignments[i]);
+                            moved = true;
+                        }
+                    }
+                }
+
+                transient.Offset = offset;
+                heapSize = std::max(heapSize, offset + transient.Size);
+                placed.push_back(i);
+            }
+
+            // Transients sharing memory never share a lifetime, placement made sure of that
+            for (uint32_t i = 0; i < mPlannedTransients.size(); ++i) {
+                Transient &transient = mPlannedTransients[i];
+                for (uint32_t j = 0; j < mPlannedTransients.size(); ++j) {
+                    const Transient &other = mPlannedTransients[j];
+                    if (j != i && other.Offset < transient.Offset + transient.Size &&
+                        transient.Offset < other.Offset + other.Size) {
+                        transient.Aliases.push_back(j);
+                    }
+                }
+            }
+
+            mHeap = nullptr;
+            if (heapSize > 0) {
+                nvrhi::HeapDesc heapDesc;
+                heapDesc.capacity = heapSize;
+                heapDesc.type = nvrhi::HeapType::DeviceLocal;
+                heapDesc.debugName = "FrameGraph::TransientHeap";
+                mHeap = mDevice->createHeap(heapDesc);
+
+                for (auto &transient: mPlannedTransients) {
+                    if (!mDevice->bindTextureMemory(transient.Texture, mHeap, transient.Offset)) {
+                        throw Engine::RuntimeException("FrameGraph: Failed to bind transient texture memory.");
+                    }
+                }
+            }
+
+            // Textures of the previous layout are released with their last command list by nvrhi
+            mTransients.swap(mPlannedTransients);
+        }
+
+        mStatistics.TransientTextures = static_cast<uint32_t>(mTransients.size());
+        mStatistics.HeapBytes = mHeap ? mHeap->getDesc().capacity : 0;
+        for (const auto &transient: mTransients) {
+            mStatistics.TransientBytes += transient.Size;
+        }
+    }
+
+    nvrhi::IFramebuffer *FrameGraph::GetPassFramebuffer(const Pass &pass) {
+        if (pass.Writes.empty()) {
+            return nullptr;
+        }
+
+        std::vector<nvrhi::ITexture *> attachments;
+        for (uint32_t write: pass.Writes) {
+            attachments.push_back(GetTexture({write}));
+        }
+
+        if (auto it = mFramebuffers.find(attachments); it != mFramebuffers.end()) {
+            return it->second;
+        }
+
+        nvrhi::FramebufferDesc desc;
+        for (uint32_t write: pass.Writes) {
+            if (IsDepthFormat(mResources[write].Desc.Format)) {
+                desc.setDepthAttachment(GetTexture({write}));
+            } else {
+                desc.addColorAttachment(GetTexture({write}));
+            }
+        }
+
+        if (mFramebuffers.size() >= MaxCachedFramebuffers) {
+            mFramebuffers.clear();
+        }
+        return mFramebuffers.emplace(std::move(attachments), mDevice->createFramebuffer(desc)).first->second;
+    }
+}
@@ -0,0 +1,188 @@
+export module Render.FrameGraph;
+
+import Vendor.ApplicationAPI;
+import Core.Prelude;
+
+namespace Engine {
+    // Texture of a frame graph, valid until the graph's next Reset
+    export struct FrameGraphTexture {
+        static constexpr uint32_t InvalidIndex = static_cast<uint32_t>(-1);
+
+        uint32_t Index = InvalidIndex;
+
+        [[nodiscard]] bool IsNull() const {
+            return Index == InvalidIndex;
+        }
+
+        bool operator==(const FrameGraphTexture &) const = default;
+    };
+
+    // Render target owned by the graph. Its memory may be shared with transients that are not alive at the same
+    // time, so the contents never survive the frame: the first pass writing it finds it cleared to ClearColor,
+    // or to depth 1 and stencil 0 for depth formats.
+    export struct FrameGraphTextureDesc {
+        uint32_t Width = 0;
+        uint32_t Height = 0;
+        nvrhi::Format Format = nvrhi::Format::RGBA8_UNORM;
+        nvrhi::Color ClearColor{0.0f};
+        const char *DebugName = "FrameGraph::Transient";
+
+        bool operator==(const FrameGraphTextureDesc &other) const {
+            return Width == other.Width && Height == other.Height && Format == other.Format;
+        }
+    };
+
+    export struct FrameGraphStatistics {
+        uint32_t Passes = 0;
+        uint32_t CulledPasses = 0;          // Declared but contributing to no imported texture or side effect
+        uint32_t TransientTextures = 0;
+        uint32_t TransientRebuilds = 0;     // 1 if the transients changed since the previous frame and were recreated
+        uint64_t TransientBytes = 0;        // Sum of the transients' sizes, what separate allocations would take
+        uint64_t HeapBytes = 0;             // Memory actually backing them after aliasing
+    };
+
+    export class FrameGraph;
+
+    // Declares what a pass touches, passed to the setup callback of FrameGraph::AddPass
+    export class FrameGraphPassBuilder {
+    public:
+        // A new transient texture, written by this pass
+        FrameGraphTexture Create(const FrameGraphTextureDesc &desc);
+
+        // Sampled by the pass, in ShaderResource state while it runs
+        FrameGraphTexture Read(FrameGraphTexture texture);
+
+        // Rendered to by the pass. Written textures become the attachments of the pass's framebuffer, colors in
+        // the order they were declared.
+        FrameGraphTexture Write(FrameGraphTexture texture);
+
+        // Keeps the pass even when nothing it writes is used, for passes with effects the graph cannot see
+        void SetSideEffect();
+
+    private:
+        friend class FrameGraph;
+
+        FrameGraphPassBuilder(FrameGraph &graph, uint32_t pass) : mGraph(graph), mPass(pass) {}
+
+        FrameGraph &mGraph;
+        uint32_t mPass;
+    };
+
+    // Handed to the execute callback of a pass, with every declared texture in its required state
+    export class FrameGraphPassContext {
+    public:
+        [[nodiscard]] nvrhi::ICommandList *GetCommandList() const {
+            return mCommandList;
+        }
+
+        [[nodiscard]] nvrhi::ITexture *GetTexture(FrameGraphTexture texture) const;
+
+        // Framebuffer over the textures the pass writes, null if it writes none
+        [[nodiscard]] nvrhi::IFramebuffer *GetFramebuffer() const {
+            return mFramebuffer;
+        }
+
+    private:
+        friend class FrameGraph;
+
+        FrameGraphPassContext(const FrameGraph &graph, nvrhi::ICommandList *commandList,
+                              nvrhi::IFramebuffer *framebuffer)
+            : mGraph(graph), mCommandList(commandList), mFramebuffer(framebuffer) {}
+
+        const FrameGraph &mGraph;
+        nvrhi::ICommandList *mCommandList;
+        nvrhi::IFramebuffer *mFramebuffer;
+    };
+
+    // Off-screen passes of one frame. Layers declare passes with the textures they read and write, the graph
+    // drops passes whose results are never used, transitions every texture once per pass and places transient
+    // render targets in one heap, where textures whose lifetimes do not overlap share memory.
+    //
+    // Passes run in declaration order. A pass is kept if it writes an imported texture, is marked as having side
+    // effects, or writes a texture a kept later pass reads. Transient placement is recomputed only when the
+    // transients or their lifetimes change, a steady frame reuses last frame's textures and heap.
+    export class FrameGraph {
+    public:
+        using SetupCallback = std::function<void(FrameGraphPassBuilder &)>;
+        using ExecuteCallback = std::function<void(FrameGraphPassContext &)>;
+
+        explicit FrameGraph(nvrhi::IDevice *device);
+
+        // Drops the passes and imports of the previous frame, the transient allocations are kept for reuse
+        void Reset();
+
+        // A texture owned elsewhere, such as a back buffer. Passes writing it are always kept, its state is left
+        // to nvrhi's tracking once the graph is done.
+        FrameGraphTexture Import(nvrhi::ITexture *texture);
+
+        // setup runs immediately, execute runs from Execute if the pass is kept
+        void AddPass(std::string_view name, const SetupCallback &setup, ExecuteCallback execute);
+
+        // Culls passes, places the transients and records every kept pass into commandList, which must be open
+        void Execute(nvrhi::ICommandList *commandList);
+
+        // Transient textures only exist while Execute runs, use FrameGraphPassContext::GetTexture
+        [[nodiscard]] nvrhi::ITexture *GetTexture(FrameGraphTexture texture) const;
+
+        [[nodiscard]] const FrameGraphStatistics &GetStatistics() const {
+            return mStatistics;
+        }
+
+    private:
+        friend class FrameGraphPassBuilder;
+
+        struct Pass {
+            std::string Name;
+            ExecuteCallback Execute;
+            std::vector<uint32_t> Reads;
+            std::vector<uint32_t> Writes;
+            bool SideEffect = false;
+            bool Kept = false;
+        };
+
+        struct Resource {
+            nvrhi::ITexture *Imported = nullptr;
+            FrameGraphTextureDesc Desc;
+            uint32_t Transient = FrameGraphTexture::InvalidIndex;  // Index into mTransients when not imported
+        };
+
+        // Transient of the current layout, the textures stay alive across frames while the layout is unchanged
+        struct Transient {
+            FrameGraphTextureDesc Desc;
+            uint32_t FirstPass = 0;
+            uint32_t LastPass = 0;
+            uint64_t Offset = 0;
+            uint64_t Size = 0;
+            nvrhi::TextureHandle Texture;
+            std::vector<uint32_t> Aliases;  // Other transients placed in overlapping memory
+            // Where the graph left the texture, carried into the next frame. Unknown until first used.
+            nvrhi::ResourceStates State = nvrhi::ResourceStates::Unknown;
+
+            bool operator==(const Transient &other) const {
+                return Desc == other.Desc && FirstPass == other.FirstPass && LastPass == other.LastPass;
+            }
+        };
+
+        uint32_t AddResource(Resource resource);
+
+        void CullPasses();
+
+        // Finds every transient's lifetime among the kept passes, rebuilding textures and heap if they changed
+        void PlaceTransients();
+
+        nvrhi::IFramebuffer *GetPassFramebuffer(const Pass &pass);
+
+        nvrhi::DeviceHandle mDevice;
+        std::vector<Pass> mPasses;
+        std::vector<Resource> mResources;
+
+        std::vector<Transient> mTransients;
+        std::vector<Transient> mPlannedTransients;
+        nvrhi::HeapHandle mHeap;
+
+        // Attachments to framebuffer, cleared when the transients are rebuilt or it grows too large
+        std::map<std::vector<nvrhi::ITexture *>, nvrhi::FramebufferHandle> mFramebuffers;
+
+        FrameGraphStatistics mStatistics;
+    };
+}
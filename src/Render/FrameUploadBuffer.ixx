@@ -0,0 +1,131 @@
+export module Render.FrameUploadBuffer;
+
+import Vendor.ApplicationAPI;
+import Core.Prelude;
+
+namespace
+Engine {
+    // Host-visible buffer with one persistently mapped copy per frame in flight. The CPU writes a frame's data
+    // straight into GPU-visible memory, so there is no staging vector and no upload copy. The owner must make
+    // sure the GPU finished the frame that last used a slot before calling BeginFrame with it again.
+    //
+    // A slot doubles as soon as a frame outgrows it, but only halves after it stayed below a quarter full for
+    // ShrinkAfterFrames uses in a row, so one spike frame does not pin its memory forever and a scene near a
+    // boundary does not reallocate every other frame.
+    export template<typename T>
+    class FrameUploadBuffer {
+    public:
+        static constexpr uint32_t ShrinkAfterFrames = 300;
+
+        FrameUploadBuffer() = default;
+
+        // usageDesc provides the usage flags, initial state and debug name, the size is managed here
+        FrameUploadBuffer(nvrhi::IDevice *device, const nvrhi::BufferDesc &usageDesc,
+                          size_t initialCapacity, uint32_t framesInFlight)
+            : mDevice(device), mUsageDesc(usageDesc), mFrames(framesInFlight), mInitialCapacity(initialCapacity) {
+            for (auto &frame: mFrames) {
+                Reallocate(frame, initialCapacity);
+            }
+            mCurrent = &mFrames.front();
+        }
+
+        FrameUploadBuffer(const FrameUploadBuffer &) = delete;
+
+        FrameUploadBuffer &operator=(const FrameUploadBuffer &) = delete;
+
+        FrameUploadBuffer(FrameUploadBuffer &&) = default;
+
+        FrameUploadBuffer &operator=(FrameUploadBuffer &&) = default;
+
+        ~FrameUploadBuffer() {
+            for (auto &frame: mFrames) {
+                if (frame.Buffer) {
+                    mDevice->unmapBuffer(frame.Buffer);
+                }
+            }
+        }
+
+        void BeginFrame(uint32_t frameSlot) {
+            Frame &frame = mFrames[frameSlot];
+            const bool lowUsage = frame.Capacity > mInitialCapacity && frame.Size < frame.Capacity / 4;
+            frame.LowUsageFrames = lowUsage ? frame.LowUsageFrames + 1 : 0;
+            frame.Size = 0;
+
+            // The GPU is done with the slot's buffer, so it can be replaced without waiting
+            if (frame.LowUsageFrames >= ShrinkAfterFrames) {
+                Reallocate(frame, std::max(mInitialCapacity, frame.Capacity / 2));
+                frame.LowUsageFrames = 0;
+            }
+
+            mCurrent = &frame;
+            mGrowthCount = 0;
+        }
+
+        // Storage for count elements in the current frame's buffer, firstElement receives the index of the first
+        // one. Growing replaces the buffer, so pointers from earlier calls in the same frame become invalid.
+        T *Allocate(size_t count, uint32_t &firstElement) {
+            Frame &frame = *mCurrent;
+            if (frame.Size + count > frame.Capacity) {
+                Reallocate(frame, std::max(frame.Capacity * 2, frame.Size + count));
+                ++mGrowthCount;
+            }
+
+            firstElement = static_cast<uint32_t>(frame.Size);
+            T *data = frame.Data + frame.Size;
+            frame.Size += count;
+            return data;
+        }
+
+        [[nodiscard]] nvrhi::IBuffer *GetBuffer() const {
+            return mCurrent->Buffer;
+        }
+
+        // Elements allocated in the current frame
+        [[nodiscard]] size_t GetSize() const {
+            return mCurrent->Size;
+        }
+
+        // Number of times the current frame's buffer had to be replaced by a larger one since BeginFrame
+        [[nodiscard]] uint32_t GetGrowthCount() const {
+            return mGrowthCount;
+        }
+
+    private:
+        struct Frame {
+            nvrhi::BufferHandle Buffer;
+            T *Data = nullptr;
+            size_t Size = 0;
+            size_t Capacity = 0;
+            uint32_t LowUsageFrames = 0;  // Consecutive uses of the slot that stayed below a quarter of Capacity
+        };
+
+        void Reallocate(Frame &frame, size_t capacity) {
+            nvrhi::BufferDesc desc = mUsageDesc;
+            desc.byteSize = sizeof(T) * capacity;
+            desc.cpuAccess = nvrhi::CpuAccessMode::Write;
+            desc.keepInitialState = true;
+
+            nvrhi::BufferHandle buffer = mDevice->createBuffer(desc);
+            auto *data = static_cast<T *>(mDevice->mapBuffer(buffer, nvrhi::CpuAccessMode::Write));
+            if (data == nullptr) {
+                throw Engine::RuntimeException("FrameUploadBuffer: Failed to map upload buffer.");
+            }
+
+            if (frame.Buffer) {
+                std::memcpy(data, frame.Data, sizeof(T) * frame.Size);
+                mDevice->unmapBuffer(frame.Buffer);
+            }
+
+            frame.Buffer = std::move(buffer);
+            frame.Data = data;
+            frame.Capacity = capacity;
+        }
+
+        nvrhi::IDevice *mDevice = nullptr;
+        nvrhi::BufferDesc mUsageDesc;
+        std::vector<Frame> mFrames;
+        Frame *mCurrent = nullptr;
+        size_t mInitialCapacity = 0;
+        uint32_t mGrowthCount = 0;
+    };
+}
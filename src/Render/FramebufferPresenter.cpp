@@ -11,27 +11,127 @@ namespace Engine {
         CreateResources(targetFramebufferInfo);
     }
 
+    namespace {
+        // Destination of the scaled source within a target of targetWidth x targetHeight
+        nvrhi::Viewport ComputeViewport(const nvrhi::TextureDesc& source, float targetWidth, float targetHeight,
+                                        PresentScaling scaling) {
+            const float sourceWidth = static_cast<float>(source.width);
+            const float sourceHeight = static_cast<float>(source.height);
+            float scale = std::min(targetWidth / sourceWidth, targetHeight / sourceHeight);
+
+            switch (scaling) {
+                case PresentScaling::Stretch:
+                    return nvrhi::Viewport(targetWidth, targetHeight);
+                case PresentScaling::Letterbox:
+                    break;
+                case PresentScaling::Integer:
+                    // Never below 1, a source larger than the target is cropped rather than unevenly shrunk
+                    scale = std::max(1.0f, std::floor(scale));
+                    break;
+            }
+
+            const float width = sourceWidth * scale;
+            const float height = sourceHeight * scale;
+            // Whole-pixel offsets keep integer scaled texels aligned with the target's pixels
+            const float x = std::floor((targetWidth - width) * 0.5f);
+            const float y = std::floor((targetHeight - height) * 0.5f);
+            return nvrhi::Viewport(x, x + width, y, y + height, 0.0f, 1.0f);
+        }
+
+        unsigned long GetReferenceCount(nvrhi::IResource* resource) {
+            resource->AddRef();
+            return resource->Release();
+        }
+    }
+
     void FramebufferPresenter::Present(nvrhi::ICommandList* commandList,
                                        nvrhi::ITexture* sourceTexture,
-                                       nvrhi::IFramebuffer* targetFramebuffer) {
-        nvrhi::BindingSetDesc setDesc;
-        setDesc.bindings = {
-            nvrhi::BindingSetItem::Texture_SRV(0, sourceTexture),
-            nvrhi::BindingSetItem::Sampler(0, mSampler)
-        };
-        auto bindingSet = mDevice->createBindingSet(setDesc, mBindingLayout);
+                                       nvrhi::IFramebuffer* targetFramebuffer,
+                                       const PresentOptions& options) {
+        ReleaseUnusedBindingSets();
+
+        const nvrhi::TextureDesc& sourceDesc = sourceTexture->getDesc();
+        const nvrhi::FramebufferDesc& targetDesc = targetFramebuffer->getDesc();
+
+        if (!options.Blend && targetDesc.colorAttachments.size() == 1 && !targetDesc.depthAttachment.valid()) {
+            nvrhi::ITexture* targetTexture = targetDesc.colorAttachments[0].texture;
+            const nvrhi::TextureDesc& targetTextureDesc = targetTexture->getDesc();
+            if (sourceDesc.width == targetTextureDesc.width && sourceDesc.height == targetTextureDesc.height &&
+                sourceDesc.format == targetTextureDesc.format && sourceDesc.sampleCount == 1 &&
+                targetTextureDesc.sampleCount == 1) {
+                // Every scaling mode maps a same-sized source onto the whole target, no draw needed
+                commandList->copyTexture(targetTexture, nvrhi::TextureSlice(), sourceTexture, nvrhi::TextureSlice());
+                ++mStatistics.Copies;
+                return;
+            }
+        }
+
+        const nvrhi::BindingSetHandle bindingSet = GetBindingSet(sourceTexture,
+                                                                 options.Scaling == PresentScaling::Integer);
 
         commandList->setResourceStatesForFramebuffer(targetFramebuffer);
         commandList->setResourceStatesForBindingSet(bindingSet);
 
+        const nvrhi::FramebufferInfoEx& targetInfo = targetFramebuffer->getFramebufferInfo();
+        const nvrhi::Viewport viewport = ComputeViewport(sourceDesc, static_cast<float>(targetInfo.width),
+                                                         static_cast<float>(targetInfo.height), options.Scaling);
+        const nvrhi::Rect scissor(std::max(0, static_cast<int>(viewport.minX)),
+                                  std::min(static_cast<int>(targetInfo.width), static_cast<int>(viewport.maxX)),
+                                  std::max(0, static_cast<int>(viewport.minY)),
+                                  std::min(static_cast<int>(targetInfo.height), static_cast<int>(viewport.maxY)));
+
         nvrhi::GraphicsState state;
-        state.pipeline = mPipeline;
+        state.pipeline = options.Blend ? mPipeline : mOpaquePipeline;
         state.framebuffer = targetFramebuffer;
         state.bindings = {bindingSet};
-        state.viewport.addViewportAndScissorRect(targetFramebuffer->getFramebufferInfo().getViewport());
+        state.viewport.addViewport(viewport);
+        state.viewport.addScissorRect(scissor);
 
         commandList->setGraphicsState(state);
         commandList->draw(nvrhi::DrawArguments().setVertexCount(3));
+        ++mStatistics.Draws;
+    }
+
+    PresenterStatistics FramebufferPresenter::GetStatistics() const {
+        PresenterStatistics statistics = mStatistics;
+        statistics.CachedBindingSets = 0;
+        for (const auto& [texture, binding]: mBindingSets) {
+            statistics.CachedBindingSets += (binding.Linear ? 1 : 0) + (binding.Point ? 1 : 0);
+        }
+        return statistics;
+    }
+
+    nvrhi::BindingSetHandle FramebufferPresenter::GetBindingSet(nvrhi::ITexture* sourceTexture, bool point) {
+        CachedBinding& binding = mBindingSets[sourceTexture];
+        if (!binding.Source) {
+            binding.Source = sourceTexture;
+            binding.CacheReferences = 1;
+        }
+
+        nvrhi::BindingSetHandle& bindingSet = point ? binding.Point : binding.Linear;
+        if (!bindingSet) {
+            nvrhi::BindingSetDesc setDesc;
+            setDesc.bindings = {
+                nvrhi::BindingSetItem::Texture_SRV(0, sourceTexture),
+                nvrhi::BindingSetItem::Sampler(0, point ? mPointSampler : mSampler)
+            };
+
+            // Counted rather than assumed, how many references a binding set keeps is up to the backend
+            const unsigned long before = GetReferenceCount(sourceTexture);
+            bindingSet = mDevice->createBindingSet(setDesc, mBindingLayout);
+            binding.CacheReferences += GetReferenceCount(sourceTexture) - before;
+            ++mStatistics.BindingSetsCreated;
+        }
+
+        return bindingSet;
+    }
+
+    void FramebufferPresenter::ReleaseUnusedBindingSets() {
+        // Command lists in flight also hold references, a texture is only released here after its last use
+        std::erase_if(mBindingSets, [](const auto& entry) {
+            const CachedBinding& binding = entry.second;
+            return GetReferenceCount(binding.Source) <= binding.CacheReferences;
+        });
     }
 
     void FramebufferPresenter::CreateResources(const nvrhi::FramebufferInfo& targetFramebufferInfo) {
@@ -39,6 +139,10 @@ namespace Engine {
             .setAllAddressModes(nvrhi::SamplerAddressMode::Clamp)
             .setAllFilters(true));
 
+        mPointSampler = mDevice->createSampler(nvrhi::SamplerDesc()
+            .setAllAddressModes(nvrhi::SamplerAddressMode::Clamp)
+            .setAllFilters(false));
+
         nvrhi::BindingLayoutDesc layoutDesc;
         layoutDesc.visibility = nvrhi::ShaderType::Pixel;
         layoutDesc.bindings = {
@@ -78,6 +182,9 @@ namespace Engine {
         pipeDesc.renderState.depthStencilState.depthTestEnable = false;
 
         mPipeline = mDevice->createGraphicsPipeline(pipeDesc, targetFramebufferInfo);
+
+        pipeDesc.renderState.blendState.targets[0].blendEnable = false;
+        mOpaquePipeline = mDevice->createGraphicsPipeline(pipeDesc, targetFramebufferInfo);
     }
 }
 
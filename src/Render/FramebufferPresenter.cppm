@@ -5,21 +5,68 @@ import Core.Prelude;
 import Render.GeneratedShaders;
 
 namespace Engine {
+    export enum class PresentScaling {
+        Stretch,    // Fills the target, ignoring the source's aspect ratio
+        Letterbox,  // Largest size with the source's aspect ratio, centered
+        Integer     // Largest whole multiple of the source size, centered and point sampled
+    };
+
+    export struct PresentOptions {
+        PresentScaling Scaling = PresentScaling::Stretch;
+
+        // Blends the source over the target by its alpha. Without blending, a source matching the target in size
+        // and format is copied instead of drawn.
+        bool Blend = true;
+    };
+
+    export struct PresenterStatistics {
+        uint32_t Draws = 0;
+        uint32_t Copies = 0;
+        uint32_t BindingSetsCreated = 0;
+        uint32_t CachedBindingSets = 0;
+    };
+
+    // Draws a texture into a framebuffer in a single pass. Areas of the target outside the scaled image, the bars
+    // of Letterbox and Integer, are left untouched.
+    //
+    // Binding sets are cached per source texture. An entry is dropped once the binding set and the cache hold the
+    // only references to its texture, so a texture released by its owner is released here as well.
     export class FramebufferPresenter {
     public:
         FramebufferPresenter(nvrhi::IDevice* device, const nvrhi::FramebufferInfo& targetFramebufferInfo);
 
         void Present(nvrhi::ICommandList* commandList,
                     nvrhi::ITexture* sourceTexture,
-                    nvrhi::IFramebuffer* targetFramebuffer);
+                    nvrhi::IFramebuffer* targetFramebuffer,
+                    const PresentOptions& options = {});
+
+        // Statistics accumulate until reset, the cached count is current
+        [[nodiscard]] PresenterStatistics GetStatistics() const;
+
+        void ResetStatistics() { mStatistics = {}; }
 
     private:
+        struct CachedBinding {
+            nvrhi::TextureHandle Source;
+            nvrhi::BindingSetHandle Linear;
+            nvrhi::BindingSetHandle Point;
+            unsigned long CacheReferences = 0;  // References to Source held by the handles above
+        };
+
         void CreateResources(const nvrhi::FramebufferInfo& targetFramebufferInfo);
 
+        nvrhi::BindingSetHandle GetBindingSet(nvrhi::ITexture* sourceTexture, bool point);
+
+        void ReleaseUnusedBindingSets();
+
         nvrhi::DeviceHandle mDevice;
         nvrhi::SamplerHandle mSampler;
+        nvrhi::SamplerHandle mPointSampler;
         nvrhi::BindingLayoutHandle mBindingLayout;
         nvrhi::GraphicsPipelineHandle mPipeline;
+        nvrhi::GraphicsPipelineHandle mOpaquePipeline;
+
+        std::unordered_map<nvrhi::ITexture*, CachedBinding> mBindingSets;
+        PresenterStatistics mStatistics;
     };
 }
-
@@ -2,6 +2,8 @@ export module Render.Image;
 import Vendor.GraphicsAPI;
 import "stb_image.h";
 import Core.Prelude;
+import Core.FileSystem;
+import Core.ThreadPool;
 
 namespace
 Engine {
@@ -18,6 +20,7 @@ Engine {
         bool keepInitialState = true;
     };
 
+    // Blocks until the upload has finished on the GPU, TextureUploader spreads uploads across frames instead
     export std::vector<nvrhi::TextureHandle> UploadImagesToGPU(
         std::span<const SimpleGPUImageDescriptor> descriptors,
         const nvrhi::DeviceHandle &device,
@@ -84,9 +87,19 @@ Engine {
         }
     };
 
+    // Pool shared by every asynchronous image decode, sized to leave one hardware thread for the main loop
+    export ThreadPool &GetImageDecodePool() {
+        static ThreadPool pool(std::max(2u, std::thread::hardware_concurrency()) - 1);
+        return pool;
+    }
+
     export CPUSimpleImage LoadImageFromFile(const std::filesystem::path& filePath) {
+        MappedFile file(filePath);
+        const std::span<const uint8_t> bytes = file.GetData();
+
         int width, height, channels;
-        stbi_uc* imgData = stbi_load(filePath.string().c_str(), &width, &height, &channels, 4);
+        stbi_uc* imgData = stbi_load_from_memory(bytes.data(), static_cast<int>(bytes.size()), &width, &height,
+                                                 &channels, 4);
         if (!imgData) {
             throw std::runtime_error("Failed to load image: " + filePath.string());
         }
@@ -102,9 +115,13 @@ Engine {
         };
     }
 
+    // Decodes on GetImageDecodePool, many concurrent loads queue up instead of each starting a thread
     export std::future<CPUSimpleImage> LoadImageFromFileAsync(const std::filesystem::path& filePath) {
-        return std::async(std::launch::async, [filePath]() {
+        auto task = std::make_shared<std::packaged_task<CPUSimpleImage()>>([filePath]() {
             return LoadImageFromFile(filePath);
         });
+        std::future<CPUSimpleImage> future = task->get_future();
+        GetImageDecodePool().Submit([task]() { (*task)(); });
+        return future;
     }
 }
@@ -0,0 +1,183 @@
+module Render.ImageLoader;
+
+import Vendor.ApplicationAPI;
+import Core.Prelude;
+import Core.FileSystem;
+import Core.ThreadPool;
+import Render.Image;
+import "stb_image.h";
+
+namespace Engine {
+    namespace {
+        using Milliseconds = std::chrono::duration<float, std::milli>;
+
+        struct BatchImage {
+            MappedFile File;
+            uint64_t FileBytes = 0;
+            uint32_t Width = 0;
+            uint32_t Height = 0;
+            nvrhi::StagingTextureHandle Staging;
+            uint8_t *StagingData = nullptr;
+            size_t StagingRowPitch = 0;
+        };
+
+        uint64_t GetPixelBytes(const BatchImage &image) {
+            return static_cast<uint64_t>(image.Width) * image.Height * sizeof(uint32_t);
+        }
+    }
+
+    ImageBatchLoader::ImageBatchLoader(nvrhi::IDevice *device, uint64_t maxStagingBytes)
+        : mDevice(device), mWindowCompleted(mDevice->createEventQuery()), mMaxStagingBytes(maxStagingBytes) {}
+
+    ImageBatchResult ImageBatchLoader::Load(std::span<const std::filesystem::path> paths,
+                                            nvrhi::ICommandList *commandList) {
+        const auto start = std::chrono::steady_clock::now();
+        ThreadPool &pool = GetImageDecodePool();
+
+        ImageBatchResult result;
+        result.Textures.resize(paths.size());
+        result.Errors.resize(paths.size());
+        result.Latencies.resize(paths.size());
+
+        // Mapping and reading the header touches only the first pages of each file
+        std::vector<BatchImage> images(paths.size());
+        pool.ParallelForChunks(paths.size(), 16, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                try {
+                    images[i].File = MappedFile(paths[i]);
+                } catch (const std::exception &exception) {
+                    result.Errors[i] = exception.what();
+                    continue;
+                }
+
+                const std::span<const uint8_t> bytes = images[i].File.GetData();
+                images[i].FileBytes = bytes.size();
+                int width, height, channels;
+                if (!stbi_info_from_memory(bytes.data(), static_cast<int>(bytes.size()), &width, &height,
+                                           &channels)) {
+                    result.Errors[i] = "Unsupported image format: " + paths[i].string();
+                    images[i].File = {};
+                    continue;
+                }
+                images[i].Width = static_cast<uint32_t>(width);
+                images[i].Height = static_cast<uint32_t>(height);
+            }
+        });
+
+        for (size_t windowBegin = 0; windowBegin < images.size();) {
+            // At least one image per window, however large
+            size_t windowEnd = windowBegin;
+            uint64_t windowBytes = 0;
+            while (windowEnd < images.size() &&
+                   (windowEnd == windowBegin || windowBytes + GetPixelBytes(images[windowEnd]) <= mMaxStagingBytes)) {
+                windowBytes += GetPixelBytes(images[windowEnd]);
+                ++windowEnd;
+            }
+
+            for (size_t i = windowBegin; i < windowEnd; ++i) {
+                BatchImage &image = images[i];
+                if (!result.Errors[i].empty()) {
+                    continue;
+                }
+
+                nvrhi::TextureDesc stagingDesc;
+                stagingDesc.width = image.Width;
+                stagingDesc.height = image.Height;
+                stagingDesc.format = nvrhi::Format::RGBA8_UNORM;
+                stagingDesc.debugName = "ImageBatchLoader::Staging";
+                image.Staging = mDevice->createStagingTexture(stagingDesc, nvrhi::CpuAccessMode::Write);
+                image.StagingData = static_cast<uint8_t *>(mDevice->mapStagingTexture(
+                    image.Staging, nvrhi::TextureSlice(), nvrhi::CpuAccessMode::Write, &image.StagingRowPitch));
+                if (!image.StagingData) {
+                    result.Errors[i] = "Failed to map staging memory for " + paths[i].string();
+                    image.Staging = nullptr;
+                }
+            }
+
+            // stb_image cannot decode into caller memory, so its output is copied once, row by row into staging
+            pool.ParallelForChunks(windowEnd - windowBegin, 1, [&](size_t begin, size_t end) {
+                for (size_t i = windowBegin + begin; i < windowBegin + end; ++i) {
+                    BatchImage &image = images[i];
+                    if (!image.StagingData) {
+                        continue;
+                    }
+
+                    const std::span<const uint8_t> bytes = image.File.GetData();
+                    int width, height, channels;
+                    stbi_uc *pixels = stbi_load_from_memory(bytes.data(), static_cast<int>(bytes.size()), &width,
+                                                            &height, &channels, 4);
+                    if (!pixels || static_cast<uint32_t>(width) != image.Width ||
+                        static_cast<uint32_t>(height) != image.Height) {
+                        result.Errors[i] = "Failed to decode image: " + paths[i].string();
+                    } else {
+                        const size_t rowBytes = static_cast<size_t>(width) * sizeof(uint32_t);
+                        for (uint32_t row = 0; row < image.Height; ++row) {
+                            std::memcpy(image.StagingData + row * image.StagingRowPitch, pixels + row * rowBytes,
+                                        rowBytes);
+                        }
+                    }
+                    stbi_image_free(pixels);
+                    image.File = {};
+
+                    result.Latencies[i] = std::chrono::steady_clock::now() - start;
+                }
+            });
+
+            commandList->open();
+            for (size_t i = windowBegin; i < windowEnd; ++i) {
+                BatchImage &image = images[i];
+                if (!image.Staging) {
+                    continue;
+                }
+
+                mDevice->unmapStagingTexture(image.Staging);
+                if (result.Errors[i].empty()) {
+                    nvrhi::TextureDesc textureDesc;
+                    textureDesc.width = image.Width;
+                    textureDesc.height = image.Height;
+                    textureDesc.format = nvrhi::Format::RGBA8_UNORM;
+                    textureDesc.debugName = paths[i].filename().string();
+                    textureDesc.initialState = nvrhi::ResourceStates::ShaderResource;
+                    textureDesc.keepInitialState = true;
+                    result.Textures[i] = mDevice->createTexture(textureDesc);
+
+                    commandList->copyTexture(result.Textures[i], nvrhi::TextureSlice(), image.Staging,
+                                             nvrhi::TextureSlice());
+                    result.Statistics.PixelBytes += GetPixelBytes(image);
+                }
+                // The command list keeps the staging texture alive until the copy has executed
+                image.Staging = nullptr;
+            }
+            commandList->close();
+
+            // Wait for the copies and let nvrhi release the window's staging textures before staging the next one
+            mDevice->resetEventQuery(mWindowCompleted);
+            mDevice->executeCommandList(commandList);
+            mDevice->setEventQuery(mWindowCompleted, nvrhi::CommandQueue::Graphics);
+            mDevice->waitEventQuery(mWindowCompleted);
+            mDevice->runGarbageCollection();
+
+            ++result.Statistics.StagingWindows;
+            windowBegin = windowEnd;
+        }
+
+        ImageBatchStatistics &statistics = result.Statistics;
+        statistics.WallTime = std::chrono::steady_clock::now() - start;
+        Milliseconds totalLatency{};
+        for (size_t i = 0; i < paths.size(); ++i) {
+            if (!result.Textures[i]) {
+                ++statistics.Failed;
+                continue;
+            }
+            ++statistics.Loaded;
+            totalLatency += result.Latencies[i];
+            statistics.MaxLatency = std::max(statistics.MaxLatency, result.Latencies[i]);
+            statistics.FileBytes += images[i].FileBytes;
+        }
+        if (statistics.Loaded > 0) {
+            statistics.AverageLatency = totalLatency / static_cast<float>(statistics.Loaded);
+        }
+
+        return result;
+    }
+}
@@ -0,0 +1,59 @@
+export module Render.ImageLoader;
+
+import Vendor.ApplicationAPI;
+import Core.Prelude;
+
+namespace Engine {
+    export struct ImageBatchStatistics {
+        uint32_t Loaded = 0;
+        uint32_t Failed = 0;
+        uint64_t FileBytes = 0;
+        uint64_t PixelBytes = 0;
+        uint32_t StagingWindows = 0;    // Groups of images staged together, see ImageBatchLoader
+        std::chrono::duration<float, std::milli> WallTime{};
+        std::chrono::duration<float, std::milli> AverageLatency{};
+        std::chrono::duration<float, std::milli> MaxLatency{};
+
+        [[nodiscard]] float GetImagesPerSecond() const {
+            return WallTime.count() > 0.0f ? static_cast<float>(Loaded) * 1000.0f / WallTime.count() : 0.0f;
+        }
+
+        [[nodiscard]] float GetFileMegabytesPerSecond() const {
+            return WallTime.count() > 0.0f
+                       ? static_cast<float>(FileBytes) / (1024.0f * 1024.0f) * 1000.0f / WallTime.count()
+                       : 0.0f;
+        }
+    };
+
+    export struct ImageBatchResult {
+        // One entry per path. Textures are null and Errors non-empty for files that could not be loaded.
+        std::vector<nvrhi::TextureHandle> Textures;
+        std::vector<std::string> Errors;
+        // From the start of the batch until the file's pixels were in staging memory
+        std::vector<std::chrono::duration<float, std::milli>> Latencies;
+        ImageBatchStatistics Statistics;
+    };
+
+    // Loads many image files into RGBA8 textures at once.
+    //
+    // Files are memory mapped and decoded on GetImageDecodePool. Each decoded image is written straight into a
+    // mapped staging texture, then copied to its final texture. Staging memory is created for at most
+    // maxStagingBytes of pixels at a time: larger batches are split into windows, and each window's copies are
+    // executed and waited for before the next window is staged, so its staging memory is released first.
+    export class ImageBatchLoader {
+    public:
+        static constexpr uint64_t DefaultMaxStagingBytes = 256ull << 20;
+
+        explicit ImageBatchLoader(nvrhi::IDevice *device, uint64_t maxStagingBytes = DefaultMaxStagingBytes);
+
+        // Blocks until every texture has been copied, like UploadImagesToGPU. commandList must be closed, it is
+        // opened and executed once per window. Device objects are only created on the calling thread, which also
+        // runs nvrhi's garbage collection and so has to be the thread that renders.
+        ImageBatchResult Load(std::span<const std::filesystem::path> paths, nvrhi::ICommandList *commandList);
+
+    private:
+        nvrhi::DeviceHandle mDevice;
+        nvrhi::EventQueryHandle mWindowCompleted;
+        uint64_t mMaxStagingBytes;
+    };
+}
@@ -0,0 +1,239 @@
+module Render.PipelineCache;
+
+import Vendor.ApplicationAPI;
+import Core.Prelude;
+
+namespace Engine {
+    namespace {
+        constexpr uint32_t CacheFileMagic = 0x43505946; // "FYPC"
+        // Bump whenever the layout of CacheFileHeader changes
+        constexpr uint32_t CacheFileVersion = 1;
+
+        struct CacheFileHeader {
+            uint32_t Magic = CacheFileMagic;
+            uint32_t Version = CacheFileVersion;
+            uint32_t VendorID = 0;
+            uint32_t DeviceID = 0;
+            uint32_t DriverVersion = 0;
+            uint32_t Reserved = 0;
+            std::array<uint8_t, vk::UuidSize> PipelineCacheUUID{};
+            std::array<uint8_t, vk::UuidSize> DeviceUUID{};
+            uint64_t DataSize = 0;
+            uint64_t DataHash = 0;
+        };
+
+        uint64_t HashData(std::span<const uint8_t> data) {
+            uint64_t hash = 0xcbf29ce484222325ull;
+            for (uint8_t byte: data) {
+                hash = (hash ^ byte) * 0x100000001b3ull;
+            }
+            return hash;
+        }
+
+        std::string ToHex(std::span<const uint8_t> bytes) {
+            static constexpr char Digits[] = "0123456789abcdef";
+            std::string result;
+            result.reserve(bytes.size() * 2);
+            for (uint8_t byte: bytes) {
+                result.push_back(Digits[byte >> 4]);
+                result.push_back(Digits[byte & 0xF]);
+            }
+            return result;
+        }
+
+        std::atomic<PipelineCache *> gInstalledCache{nullptr};
+    }
+
+    PipelineCache::PipelineCache(const vk::SharedPhysicalDevice &physicalDevice, const vk::SharedDevice &device,
+                                 const std::filesystem::path &directory) : mDevice(device) {
+        auto properties = physicalDevice.get().getProperties2<vk::PhysicalDeviceProperties2,
+            vk::PhysicalDeviceIDProperties>();
+        const auto &deviceProperties = properties.get<vk::PhysicalDeviceProperties2>().properties;
+        const auto &idProperties = properties.get<vk::PhysicalDeviceIDProperties>();
+
+        mKey.VendorID = deviceProperties.vendorID;
+        mKey.DeviceID = deviceProperties.deviceID;
+        mKey.DriverVersion = deviceProperties.driverVersion;
+        std::ranges::copy(deviceProperties.pipelineCacheUUID, mKey.PipelineCacheUUID.begin());
+        std::ranges::copy(idProperties.deviceUUID, mKey.DeviceUUID.begin());
+
+        mPath = directory / ("pipeline_cache_" + ToHex(mKey.DeviceUUID) + ".bin");
+
+        std::vector<uint8_t> initialData = LoadFile();
+
+        vk::PipelineCacheCreateInfo createInfo;
+        createInfo.initialDataSize = initialData.size();
+        createInfo.pInitialData = initialData.data();
+
+        vk::PipelineCache cache;
+        vk::Result result = device.get().createPipelineCache(&createInfo, nullptr, &cache);
+        if (result != vk::Result::eSuccess && !initialData.empty()) {
+            // Drivers may still refuse data that passed our checks, starting cold is always valid
+            createInfo.initialDataSize = 0;
+            createInfo.pInitialData = nullptr;
+            initialData.clear();
+            result = device.get().createPipelineCache(&createInfo, nullptr, &cache);
+        }
+        if (result != vk::Result::eSuccess) {
+            throw Engine::RuntimeException("PipelineCache: Failed to create the pipeline cache.");
+        }
+
+        mCache = vk::SharedPipelineCache(cache, mDevice);
+        mLoadedBytes = initialData.size();
+    }
+
+    PipelineCache::~PipelineCache() {
+        Uninstall();
+    }
+
+    PipelineCacheStatistics PipelineCache::GetStatistics() const {
+        PipelineCacheStatistics statistics;
+        statistics.PipelineCount = mPipelineCount.load(std::memory_order_relaxed);
+        statistics.CreationTime = std::chrono::nanoseconds(mCreationNanoseconds.load(std::memory_order_relaxed));
+        statistics.LoadedBytes = mLoadedBytes;
+        return statistics;
+    }
+
+    void PipelineCache::Install() {
+        if (!mCache) {
+            throw Engine::RuntimeException("PipelineCache: Cannot install an empty pipeline cache.");
+        }
+
+        PipelineCache *expected = nullptr;
+        if (!gInstalledCache.compare_exchange_strong(expected, this)) {
+            if (expected == this) {
+                return;
+            }
+            throw Engine::RuntimeException("PipelineCache: Another pipeline cache is already installed.");
+        }
+
+        auto &dispatcher = vk::detail::defaultDispatchLoaderDynamic;
+        mDispatchedCreateGraphicsPipelines = dispatcher.vkCreateGraphicsPipelines;
+        mDispatchedCreateComputePipelines = dispatcher.vkCreateComputePipelines;
+        dispatcher.vkCreateGraphicsPipelines = &PipelineCache::CreateGraphicsPipelines;
+        dispatcher.vkCreateComputePipelines = &PipelineCache::CreateComputePipelines;
+    }
+
+    void PipelineCache::Uninstall() {
+        PipelineCache *expected = this;
+        if (!gInstalledCache.compare_exchange_strong(expected, nullptr)) {
+            return;
+        }
+
+        auto &dispatcher = vk::detail::defaultDispatchLoaderDynamic;
+        dispatcher.vkCreateGraphicsPipelines = mDispatchedCreateGraphicsPipelines;
+        dispatcher.vkCreateComputePipelines = mDispatchedCreateComputePipelines;
+    }
+
+    void PipelineCache::Save() const {
+        if (!mCache) {
+            return;
+        }
+
+        std::vector<uint8_t> data = mDevice.get().getPipelineCacheData(mCache.get());
+        if (data.empty()) {
+            return;
+        }
+
+        CacheFileHeader header;
+        header.VendorID = mKey.VendorID;
+        header.DeviceID = mKey.DeviceID;
+        header.DriverVersion = mKey.DriverVersion;
+        header.PipelineCacheUUID = mKey.PipelineCacheUUID;
+        header.DeviceUUID = mKey.DeviceUUID;
+        header.DataSize = data.size();
+        header.DataHash = HashData(data);
+
+        // A crash halfway through writing must not leave a truncated file behind, so write aside and rename
+        std::error_code error;
+        std::filesystem::create_directories(mPath.parent_path(), error);
+
+        std::filesystem::path temporaryPath = mPath;
+        temporaryPath += ".tmp";
+        {
+            std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char *>(data.data()), static_cast<std::streamsize>(data.size()));
+            if (!file) {
+                std::cerr << "PipelineCache: Failed to write " << temporaryPath.string() << std::endl;
+                file.close();
+                std::filesystem::remove(temporaryPath, error);
+                return;
+            }
+        }
+
+        std::filesystem::rename(temporaryPath, mPath, error);
+        if (error) {
+            std::cerr << "PipelineCache: Failed to replace " << mPath.string() << ": " << error.message() <<
+                    std::endl;
+            std::filesystem::remove(temporaryPath, error);
+        }
+    }
+
+    VkResult PipelineCache::CreateGraphicsPipelines(VkDevice device, VkPipelineCache pipelineCache,
+                                                   uint32_t createInfoCount,
+                                                   const VkGraphicsPipelineCreateInfo *createInfos,
+                                                   const VkAllocationCallbacks *allocator, VkPipeline *pipelines) {
+        PipelineCache *cache = gInstalledCache.load(std::memory_order_acquire);
+        const auto start = std::chrono::steady_clock::now();
+        VkResult result = cache->mDispatchedCreateGraphicsPipelines(device, cache->Get(), createInfoCount,
+                                                                    createInfos, allocator, pipelines);
+        cache->RecordCreation(std::chrono::steady_clock::now() - start, createInfoCount);
+        return result;
+    }
+
+    VkResult PipelineCache::CreateComputePipelines(VkDevice device, VkPipelineCache pipelineCache,
+                                                  uint32_t createInfoCount,
+                                                  const VkComputePipelineCreateInfo *createInfos,
+                                                  const VkAllocationCallbacks *allocator, VkPipeline *pipelines) {
+        PipelineCache *cache = gInstalledCache.load(std::memory_order_acquire);
+        const auto start = std::chrono::steady_clock::now();
+        VkResult result = cache->mDispatchedCreateComputePipelines(device, cache->Get(), createInfoCount,
+                                                                   createInfos, allocator, pipelines);
+        cache->RecordCreation(std::chrono::steady_clock::now() - start, createInfoCount);
+        return result;
+    }
+
+    void PipelineCache::RecordCreation(std::chrono::steady_clock::duration elapsed, uint32_t count) {
+        mPipelineCount.fetch_add(count, std::memory_order_relaxed);
+        mCreationNanoseconds.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(),
+                                       std::memory_order_relaxed);
+    }
+
+    std::vector<uint8_t> PipelineCache::LoadFile() const {
+        std::ifstream file(mPath, std::ios::binary);
+        if (!file) {
+            return {};
+        }
+
+        CacheFileHeader header;
+        if (!file.read(reinterpret_cast<char *>(&header), sizeof(header))) {
+            return {};
+        }
+
+        if (header.Magic != CacheFileMagic || header.Version != CacheFileVersion ||
+            header.VendorID != mKey.VendorID || header.DeviceID != mKey.DeviceID ||
+            header.DriverVersion != mKey.DriverVersion || header.PipelineCacheUUID != mKey.PipelineCacheUUID ||
+            header.DeviceUUID != mKey.DeviceUUID || header.DataSize < sizeof(VkPipelineCacheHeaderVersionOne)) {
+            return {};
+        }
+
+        std::vector<uint8_t> data(header.DataSize);
+        if (!file.read(reinterpret_cast<char *>(data.data()), static_cast<std::streamsize>(data.size())) ||
+            HashData(data) != header.DataHash) {
+            return {};
+        }
+
+        // Some drivers trust the blob's own header, check it as well rather than relying on them to reject it
+        VkPipelineCacheHeaderVersionOne blobHeader;
+        std::memcpy(&blobHeader, data.data(), sizeof(blobHeader));
+        if (blobHeader.headerSize < sizeof(blobHeader) ||
+            blobHeader.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE ||
+            blobHeader.vendorID != mKey.VendorID || blobHeader.deviceID != mKey.DeviceID ||
+            !std::ranges::equal(blobHeader.pipelineCacheUUID, mKey.PipelineCacheUUID)) {
+            return {};
+        }
+
+        return data;
+    }
+}
@@ -0,0 +1,89 @@
+export module Render.PipelineCache;
+
+import Vendor.ApplicationAPI;
+import Core.Prelude;
+
+namespace Engine {
+    export struct PipelineCacheStatistics {
+        // Pipelines created through the cache and the wall time spent creating them
+        uint32_t PipelineCount = 0;
+        std::chrono::duration<float, std::milli> CreationTime{};
+
+        // Size of the cache data accepted from disk, zero on a cold start
+        size_t LoadedBytes = 0;
+    };
+
+    // One VkPipelineCache shared by every pipeline the application creates, persisted between runs.
+    //
+    // The file is named after the device UUID and its header repeats the device and driver identity, so data
+    // written by another GPU or driver version is discarded instead of being handed to the driver.
+    //
+    // nvrhi creates its pipelines without a way to pass a cache, so Install() routes vkCreateGraphicsPipelines and
+    // vkCreateComputePipelines of the default dispatcher through this cache. That also times every pipeline
+    // creation, including the ones nvrhi makes on behalf of Renderer2D and FramebufferPresenter.
+    export class PipelineCache {
+    public:
+        PipelineCache() = default;
+
+        // Loads the cache file for physicalDevice from directory if it is present and still valid
+        PipelineCache(const vk::SharedPhysicalDevice &physicalDevice, const vk::SharedDevice &device,
+                      const std::filesystem::path &directory);
+
+        PipelineCache(const PipelineCache &) = delete;
+        PipelineCache &operator=(const PipelineCache &) = delete;
+        PipelineCache(PipelineCache &&) = delete;
+        PipelineCache &operator=(PipelineCache &&) = delete;
+
+        ~PipelineCache();
+
+        [[nodiscard]] vk::PipelineCache Get() const {
+            return mCache.get();
+        }
+
+        [[nodiscard]] PipelineCacheStatistics GetStatistics() const;
+
+        // Makes pipelines created through the default dispatcher use this cache, only one cache can be installed
+        void Install();
+
+        void Uninstall();
+
+        // Writes the driver's current cache data next to the loaded file, replacing it atomically
+        void Save() const;
+
+    private:
+        static VKAPI_ATTR VkResult VKAPI_CALL CreateGraphicsPipelines(
+            VkDevice device, VkPipelineCache pipelineCache, uint32_t createInfoCount,
+            const VkGraphicsPipelineCreateInfo *createInfos, const VkAllocationCallbacks *allocator,
+            VkPipeline *pipelines);
+
+        static VKAPI_ATTR VkResult VKAPI_CALL CreateComputePipelines(
+            VkDevice device, VkPipelineCache pipelineCache, uint32_t createInfoCount,
+            const VkComputePipelineCreateInfo *createInfos, const VkAllocationCallbacks *allocator,
+            VkPipeline *pipelines);
+
+        void RecordCreation(std::chrono::steady_clock::duration elapsed, uint32_t count);
+
+        [[nodiscard]] std::vector<uint8_t> LoadFile() const;
+
+        // Identity the cache data is only valid for
+        struct DeviceKey {
+            uint32_t VendorID = 0;
+            uint32_t DeviceID = 0;
+            uint32_t DriverVersion = 0;
+            std::array<uint8_t, vk::UuidSize> PipelineCacheUUID{};
+            std::array<uint8_t, vk::UuidSize> DeviceUUID{};
+        };
+
+        DeviceKey mKey;
+        std::filesystem::path mPath;
+        vk::SharedDevice mDevice;
+        vk::SharedPipelineCache mCache;
+        size_t mLoadedBytes = 0;
+
+        std::atomic<uint32_t> mPipelineCount{0};
+        std::atomic<int64_t> mCreationNanoseconds{0};
+
+        PFN_vkCreateGraphicsPipelines mDispatchedCreateGraphicsPipelines = nullptr;
+        PFN_vkCreateComputePipelines mDispatchedCreateComputePipelines = nullptr;
+    };
+}
@@ -2,41 +2,204 @@ module Render.Renderer2D;
 
 import Vendor.ApplicationAPI;
 import Core.Prelude;
+import Core.RadixSort;
+import Core.ThreadPool;
 import Render.GeneratedShaders;
 import Render.VirtualTextureManager;
 import glm;
 import <cstddef>;
+#if defined(_M_X64) || defined(__SSE2__)
+import <immintrin.h>;
+#endif
 import "glm/gtx/transform.hpp";
 
 namespace
 Engine {
+    // Quads per ellipse strip, must match kSegments in renderer2d_ellipse.vs.hlsl
+    constexpr uint32_t EllipseSegments = 8;
+
+    // Set in the sort keys of draws that cannot go to the opaque pass, see MakeDrawSortKey
+    constexpr uint64_t TranslucentSortKeyBit = 1ull << 15;
+
+    // Copies stream into merged, joining neighbours that continue the same range of one primitive type under the
+    // same clip and opacity, so a run of one type spanning several depths is still a single draw. A joined run
+    // samples textures if any of its parts does, the textured shader build handles both kinds.
+    void MergeDrawStream(const std::vector<DrawStreamEntry> &stream, std::vector<DrawStreamEntry> &merged) {
+        merged.clear();
+        for (const auto &entry: stream) {
+            if (!merged.empty()) {
+                auto &pending = merged.back();
+                if (entry.Type == pending.Type && entry.Clip == pending.Clip && entry.Opaque == pending.Opaque &&
+                    entry.First == pending.First + pending.Count) {
+                    pending.Count += entry.Count;
+                    pending.Textured = pending.Textured || entry.Textured;
+                    continue;
+                }
+            }
+            merged.push_back(entry);
+        }
+    }
+
+    // Bounds area of the elements keys reference, cut to visibleBounds, as (opaque, translucent)
+    glm::vec2 CoveredArea(const std::vector<SortKey> &keys, const std::vector<glm::vec4> &bounds,
+                          const glm::vec4 &visibleBounds) {
+        glm::vec2 area(0.0f);
+        for (const auto &key: keys) {
+            const glm::vec4 &elementBounds = bounds[key.Payload];
+            const glm::vec2 min = glm::max(glm::vec2(elementBounds), glm::vec2(visibleBounds));
+            const glm::vec2 max = glm::min(glm::vec2(elementBounds.z, elementBounds.w),
+                                           glm::vec2(visibleBounds.z, visibleBounds.w));
+            const glm::vec2 size = glm::max(max - min, glm::vec2(0.0f));
+            area[(key.Key & TranslucentSortKeyBit) != 0 ? 1 : 0] += size.x * size.y;
+        }
+        return area;
+    }
+
+    void AddCoveredArea(Renderer2DStatistics &statistics, const glm::vec2 &area) {
+        statistics.OpaqueOverdraw += area.x;
+        statistics.TranslucentOverdraw += area.y;
+    }
+
+    nvrhi::ShaderHandle CreatePixelShader(nvrhi::IDevice *device, std::span<const uint8_t> bytecode) {
+        nvrhi::ShaderDesc psDesc;
+        psDesc.shaderType = nvrhi::ShaderType::Pixel;
+        psDesc.entryName = "main";
+        return device->createShader(psDesc, bytecode.data(), bytecode.size());
+    }
+
+    // Handle in table for the clip a command list's segment references, -1 for unclipped segments
+    int32_t InternSegmentClip(ClipRegionTable &table, const ClipRegionTable &listClips, int32_t handle) {
+        return handle < 0 ? -1 : table.Intern(listClips.Regions[handle]);
+    }
+
+    // One-shot upload buffer for building static batches
+    template<typename T>
+    FrameUploadBuffer<T> CreateStagingBuffer(nvrhi::IDevice *device, size_t count) {
+        nvrhi::BufferDesc desc;
+        desc.debugName = "Renderer2D::StaticBatchStaging";
+        desc.initialState = nvrhi::ResourceStates::CopySource;
+        FrameUploadBuffer<T> staging(device, desc, std::max<size_t>(1, count), 1);
+        staging.BeginFrame(0);
+        return staging;
+    }
+
+    // GPU-local copy of what was written to staging. The staging buffer may be released right after, NVRHI
+    // keeps it alive until the copy executed.
+    template<typename T>
+    nvrhi::BufferHandle CreateStaticBuffer(nvrhi::IDevice *device, nvrhi::ICommandList *commandList,
+                                           const FrameUploadBuffer<T> &staging, nvrhi::BufferDesc desc) {
+        // At least one element, so buffers of primitive types the batch does not use can still be bound
+        desc.byteSize = sizeof(T) * std::max<size_t>(1, staging.GetSize());
+        desc.initialState = desc.isVertexBuffer
+                                ? nvrhi::ResourceStates::VertexBuffer
+                                : nvrhi::ResourceStates::ShaderResource;
+        desc.keepInitialState = true;
+
+        nvrhi::BufferHandle buffer = device->createBuffer(desc);
+        if (staging.GetSize() > 0) {
+            commandList->copyBuffer(buffer, 0, staging.GetBuffer(), 0, sizeof(T) * staging.GetSize());
+        }
+        return buffer;
+    }
+
+    Renderer2DRecorder::Renderer2DRecorder(VirtualTextureManager *virtualTextureManager, std::mutex *textureMutex)
+        : mSharedVirtualTextureManager(virtualTextureManager), mSharedVirtualTextureMutex(textureMutex) {}
+
+    void Renderer2DRecorder::Clear() {
+        mTriangleCommandList.Clear();
+        mLineCommandList.Clear();
+        mEllipseCommandList.Clear();
+        mSpriteCommandList.Clear();
+    }
+
+    void Renderer2DRecorder::BeginFrame() {
+        Clear();
+        mClipStack.clear();
+    }
+
+    void Renderer2DRecorder::Append(const Renderer2DRecorder &other) {
+        mTriangleCommandList.Append(other.mTriangleCommandList);
+        mLineCommandList.Append(other.mLineCommandList);
+        mEllipseCommandList.Append(other.mEllipseCommandList);
+        mSpriteCommandList.Append(other.mSpriteCommandList);
+    }
+
+    Renderer2D::StaticBatch::StaticBatch(nvrhi::IDevice *device)
+        : Renderer2DRecorder(&mLocalTextures, &mLocalTextureMutex), mLocalTextures(device, 1024) {
+        // The local table only hands out IDs, so it can grow whenever recording fills it
+        mGrowTexturesOnDemand = true;
+    }
+
+    void Renderer2D::StaticBatch::Invalidate() {
+        mIsDirty = true;
+    }
+
+    void Renderer2D::StaticBatch::Clear() {
+        Renderer2DRecorder::Clear();
+        // Otherwise every texture the batch ever used would be registered again on the next build
+        mLocalTextures.Reset();
+    }
+
     Renderer2D::Renderer2D(const Renderer2DDescriptor& desc)
-        : mDevice(std::move(desc.Device)), mOutputSize(desc.OutputSize),
-          mVirtualTextureManager(mDevice) {
+        : Renderer2DRecorder(&mVirtualTextureManager, &mVirtualTextureMutex),
+          mDevice(std::move(desc.Device)), mOutputSize(desc.OutputSize),
+          mVirtualTextureManager(mDevice), mFramesInFlight(std::max(1u, desc.FramesInFlight)),
+          mSubmissionThreadPool(desc.SubmissionWorkerCount) {
         mVirtualSize.x = desc.VirtualSizeWidth;
         mVirtualSize.y = desc.VirtualSizeWidth * (static_cast<float>(mOutputSize.y) / static_cast<float>(mOutputSize.x));
         CreateResources();
         CreateConstantBuffers();
         CreatePipelines();
-        CreatePipelineResources();
+        CreateFrameResources();
         RecalculateViewProjectionMatrix();
     }
 
-    void Renderer2D::CreatePipelineResources() {
-        CreateTriangleBatchRenderingResources(4);
-        // this should be enough for most cases, if not we can always expand it
-        CreateLineBatchRenderingResources(4); // same for lines
-        CreateEllipseBatchRenderingResources(4); // same for ellipses
-    }
-
     const glm::vec2& Renderer2D::BeginRendering(const nvrhi::Color& clearColor) {
-        Clear();
+        BeginFrame();
+        for (auto &recorder: mRecorders) {
+            recorder->BeginFrame();
+        }
+        mStaticDraws.clear();
+
+        // The upload buffers of this slot are overwritten below, wait until the GPU is done reading them
+        mFrameSlot = static_cast<uint32_t>(mFrameCount++ % mFramesInFlight);
+        mDevice->waitEventQuery(mFrameResources[mFrameSlot].CompletionQuery);
+
+        // The frame that last used this slot and every frame before it have finished, their textures can go
+        const uint64_t completedFrames = mFrameCount - std::min<uint64_t>(mFrameCount, mFramesInFlight);
+        mVirtualTextureManager.BeginFrame(mFrameCount, completedFrames);
+        std::erase_if(mRetiredRenderTargets, [&](const RetiredRenderTargets &targets) {
+            return targets.RetiredFrame <= completedFrames;
+        });
+
+        mResizeMilliseconds = 0.0f;
+        if (mRenderTargetsOutdated) {
+            RecreateRenderTargets();
+        }
+
+        if (mVirtualTextureManager.IsSubOptimal() &&
+            mVirtualTextureManager.GetCapacity() < mVirtualTextureManager.GetCapacityLimit()) {
+            // Everything still in the table was used recently, grow it instead. Resizing replaces the table.
+            // At the limit the table stays as it is, eviction alone has to keep up.
+            mDevice->waitForIdle();
+            mVirtualTextureManager.Optimize();
+        }
+
+        mTriangleUpload.Primitives.BeginFrame(mFrameSlot);
+        mLineUpload.Points.BeginFrame(mFrameSlot);
+        mLineUpload.Segments.BeginFrame(mFrameSlot);
+        mEllipseUpload.Shapes.BeginFrame(mFrameSlot);
+        mSpriteUpload.Primitives.BeginFrame(mFrameSlot);
 
         mCommandList->open();
 
         mCommandList->setResourceStatesForFramebuffer(mFramebuffer);
         mCommandList->clearTextureFloat(mTexture,
                                         nvrhi::AllSubresources, clearColor);
+        // Depth 1 is behind the first primitive of the draw order, see DepthConstants
+        mCommandList->clearDepthStencilTexture(mDepthStencilTexture, nvrhi::AllSubresources, true, 1.0f, true, 0);
+        mStencilReference = 0;
+        mStencilClipPoints.reset();
 
         return mVirtualSize;
     }
@@ -50,24 +213,39 @@ Engine {
         mCommandList->close();
         mDevice->executeCommandList(mCommandList);
 
-        if (mVirtualTextureManager.IsSubOptimal()) {
-            mVirtualTextureManager.Optimize();
-        }
+        auto &completionQuery = mFrameResources[mFrameSlot].CompletionQuery;
+        mDevice->resetEventQuery(completionQuery);
+        mDevice->setEventQuery(completionQuery, nvrhi::CommandQueue::Graphics);
     }
 
     void Renderer2D::OnResize(uint32_t width, uint32_t height) {
         if (width == mOutputSize.x && height == mOutputSize.y) {
             return;
         }
-        mDevice->waitForIdle();
 
         mOutputSize = glm::u32vec2(width, height);
-        mTexture.Reset();
-        mFramebuffer.Reset();
+        mRenderTargetsOutdated = true;
+        RecalculateViewProjectionMatrix();
+    }
+
+    void Renderer2D::RecreateRenderTargets() {
+        const auto start = std::chrono::steady_clock::now();
+
+        // Called after mFrameCount counted the current frame, which is the first to use the new targets. The
+        // application samples the texture after the renderer's submission, so once this frame has completed no
+        // earlier use of the old targets is left on the queue.
+        mRetiredRenderTargets.push_back({
+            .Texture = std::move(mTexture),
+            .DepthStencilTexture = std::move(mDepthStencilTexture),
+            .Framebuffer = std::move(mFramebuffer),
+            .RetiredFrame = mFrameCount
+        });
 
         CreateResources();
-        // CreatePipelineResources();
-        RecalculateViewProjectionMatrix();
+        mRenderTargetsOutdated = false;
+
+        const std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        mResizeMilliseconds = elapsed.count();
     }
 
     const glm::vec2 & Renderer2D::SetVirtualWidth(float virtualWidth) {
@@ -90,8 +268,23 @@ Engine {
 
         auto tex = mDevice->createTexture(texDesc);
         mTexture = tex;
+
+        // Depth keeps opaque draws from shading hidden pixels, stencil holds the clips that are not screen-aligned
+        // rectangles. D24S8 is the smaller format but is missing on some desktop GPUs.
+        const bool hasD24S8 = (mDevice->queryFormatSupport(nvrhi::Format::D24S8) &
+                               nvrhi::FormatSupport::DepthStencil) != nvrhi::FormatSupport::None;
+        nvrhi::TextureDesc depthStencilDesc;
+        depthStencilDesc.width = mOutputSize.x;
+        depthStencilDesc.height = mOutputSize.y;
+        depthStencilDesc.format = hasD24S8 ? nvrhi::Format::D24S8 : nvrhi::Format::D32S8;
+        depthStencilDesc.isRenderTarget = true;
+        depthStencilDesc.initialState = nvrhi::ResourceStates::DepthWrite;
+        depthStencilDesc.keepInitialState = true;
+        depthStencilDesc.debugName = "Renderer2D::DepthStencilTexture";
+        mDepthStencilTexture = mDevice->createTexture(depthStencilDesc);
+
         mFramebuffer = mDevice->createFramebuffer(
-            nvrhi::FramebufferDesc().addColorAttachment(tex));
+            nvrhi::FramebufferDesc().addColorAttachment(tex).setDepthAttachment(mDepthStencilTexture));
 
         if (!mCommandList) {
             mCommandList = mDevice->createCommandList();
@@ -100,132 +293,59 @@ Engine {
         mTextureSampler = mDevice->createSampler(nvrhi::SamplerDesc()
             .setAllAddressModes(nvrhi::SamplerAddressMode::Clamp)
             .setAllFilters(true));
-
-        vk::PhysicalDevice vkPhysicalDevice = static_cast<vk::PhysicalDevice>(
-            mDevice->getNativeObject(nvrhi::ObjectTypes::VK_PhysicalDevice)
-        );
-
-        vk::PhysicalDeviceProperties deviceProperties = vkPhysicalDevice.getProperties();
-
-        uint32_t hardwareMax = deviceProperties.limits.maxDescriptorSetSampledImages;
-
-        mBindlessTextureArraySizeMax = std::min<uint32_t>(16384u, hardwareMax);
-        mTriangleBufferInstanceSizeMax = 1 << 18; // 2^18 instances
-        mLineBufferVertexSizeMax = 1 << 18; // 2^18 vertices
-        mEllipseBufferInstanceSizeMax = 1 << 16; // 2^16 ellipses (each ellipse = 6 vertices)
-    }
-
-    void Renderer2D::CreateTriangleBatchRenderingResources(size_t count) {
-        if (count <= mTriangleBatchRenderingResources.size()) {
-            return;
-        }
-
-        for (size_t i = mTriangleBatchRenderingResources.size(); i < count; ++i) {
-            TriangleBatchRenderingResources resources;
-
-            nvrhi::BufferDesc vertexBufferDesc;
-            vertexBufferDesc.byteSize = sizeof(TriangleVertexData) * mTriangleBufferInstanceSizeMax * 4;
-            vertexBufferDesc.isVertexBuffer = true;
-            vertexBufferDesc.debugName = "Renderer2D::TriangleVertexBuffer";
-            vertexBufferDesc.initialState = nvrhi::ResourceStates::VertexBuffer;
-            vertexBufferDesc.keepInitialState = true;
-            resources.VertexBuffer = mDevice->createBuffer(vertexBufferDesc);
-
-            nvrhi::BufferDesc indexBufferDesc;
-            indexBufferDesc.byteSize = sizeof(uint32_t) * mTriangleBufferInstanceSizeMax * 6;
-            indexBufferDesc.isIndexBuffer = true;
-            indexBufferDesc.debugName = "Renderer2D::TriangleIndexBuffer";
-            indexBufferDesc.initialState = nvrhi::ResourceStates::IndexBuffer;
-            indexBufferDesc.keepInitialState = true;
-            resources.IndexBuffer = mDevice->createBuffer(indexBufferDesc);
-
-            nvrhi::BufferDesc instanceBufferDesc;
-            instanceBufferDesc.byteSize = sizeof(TriangleInstanceData) * mTriangleBufferInstanceSizeMax;
-            instanceBufferDesc.canHaveRawViews = true;
-            instanceBufferDesc.structStride = sizeof(TriangleInstanceData);
-            instanceBufferDesc.debugName = "Renderer2D::TriangleInstanceBuffer";
-            instanceBufferDesc.initialState = nvrhi::ResourceStates::ShaderResource;
-            instanceBufferDesc.keepInitialState = true;
-            resources.InstanceBuffer = mDevice->createBuffer(instanceBufferDesc);
-
-            nvrhi::BufferDesc clipBufferDesc;
-            clipBufferDesc.byteSize = sizeof(ClipRegion) * mTriangleBufferInstanceSizeMax;
-            clipBufferDesc.canHaveRawViews = true;
-            clipBufferDesc.structStride = sizeof(ClipRegion);
-            clipBufferDesc.debugName = "Renderer2D::TriangleClipBuffer";
-            clipBufferDesc.initialState = nvrhi::ResourceStates::ShaderResource;
-            clipBufferDesc.keepInitialState = true;
-            resources.ClipBuffer = mDevice->createBuffer(clipBufferDesc);
-
-            nvrhi::BindingSetDesc bindingSetDesc;
-            bindingSetDesc.addItem(nvrhi::BindingSetItem::ConstantBuffer(0, mTriangleConstantBuffer));
-            bindingSetDesc.addItem(nvrhi::BindingSetItem::StructuredBuffer_SRV(0, resources.InstanceBuffer));
-            bindingSetDesc.addItem(nvrhi::BindingSetItem::StructuredBuffer_SRV(1, resources.ClipBuffer));
-            bindingSetDesc.addItem(nvrhi::BindingSetItem::Sampler(0, mTextureSampler));
-            resources.mBindingSetSpace0 = mDevice->createBindingSet(bindingSetDesc, mTriangleBindingLayoutSpace0);
-
-            mTriangleBatchRenderingResources.push_back(resources);
-        }
-    }
-
-    void Renderer2D::CreateLineBatchRenderingResources(size_t count) {
-        if (count <= mLineBatchRenderingResources.size()) {
-            return;
-        }
-
-        for (size_t i = mLineBatchRenderingResources.size(); i < count; ++i) {
-            LineBatchRenderingResources resources;
-
-            nvrhi::BufferDesc vertexBufferDesc;
-            vertexBufferDesc.byteSize = sizeof(LineVertexData) * mLineBufferVertexSizeMax;
-            vertexBufferDesc.isVertexBuffer = true;
-            vertexBufferDesc.debugName = "Renderer2D::LineVertexBuffer";
-            vertexBufferDesc.initialState = nvrhi::ResourceStates::VertexBuffer;
-            vertexBufferDesc.keepInitialState = true;
-            resources.VertexBuffer = mDevice->createBuffer(vertexBufferDesc);
-
-            nvrhi::BindingSetDesc bindingSetDesc;
-            bindingSetDesc.addItem(nvrhi::BindingSetItem::ConstantBuffer(0, mLineConstantBuffer));
-            resources.mBindingSetSpace0 = mDevice->createBindingSet(bindingSetDesc, mLineBindingLayoutSpace0);
-
-            mLineBatchRenderingResources.push_back(resources);
-        }
     }
 
-    void Renderer2D::CreateEllipseBatchRenderingResources(size_t count) {
-        if (count <= mEllipseBatchRenderingResources.size()) {
-            return;
-        }
-
-        for (size_t i = mEllipseBatchRenderingResources.size(); i < count; ++i) {
-            EllipseBatchRenderingResources resources;
-
-            nvrhi::BufferDesc shapeBufferDesc;
-            shapeBufferDesc.byteSize = sizeof(EllipseShapeData) * mEllipseBufferInstanceSizeMax;
-            shapeBufferDesc.canHaveRawViews = true;
-            shapeBufferDesc.structStride = sizeof(EllipseShapeData);
-            shapeBufferDesc.debugName = "Renderer2D::EllipseShapeBuffer";
-            shapeBufferDesc.initialState = nvrhi::ResourceStates::ShaderResource;
-            shapeBufferDesc.keepInitialState = true;
-            resources.ShapeBuffer = mDevice->createBuffer(shapeBufferDesc);
-
-            nvrhi::BufferDesc clipBufferDesc;
-            clipBufferDesc.byteSize = sizeof(ClipRegion) * mEllipseBufferInstanceSizeMax;
-            clipBufferDesc.canHaveRawViews = true;
-            clipBufferDesc.structStride = sizeof(ClipRegion);
-            clipBufferDesc.debugName = "Renderer2D::EllipseClipBuffer";
-            clipBufferDesc.initialState = nvrhi::ResourceStates::ShaderResource;
-            clipBufferDesc.keepInitialState = true;
-            resources.ClipBuffer = mDevice->createBuffer(clipBufferDesc);
-
-            nvrhi::BindingSetDesc bindingSetDesc;
-            bindingSetDesc.addItem(nvrhi::BindingSetItem::ConstantBuffer(0, mEllipseConstantBuffer));
-            bindingSetDesc.addItem(nvrhi::BindingSetItem::StructuredBuffer_SRV(0, resources.ShapeBuffer));
-            bindingSetDesc.addItem(nvrhi::BindingSetItem::StructuredBuffer_SRV(1, resources.ClipBuffer));
-            bindingSetDesc.addItem(nvrhi::BindingSetItem::Sampler(0, mTextureSampler));
-            resources.mBindingSetSpace0 = mDevice->createBindingSet(bindingSetDesc, mEllipseBindingLayoutSpace0);
-
-            mEllipseBatchRenderingResources.push_back(resources);
+    void Renderer2D::CreateFrameResources() {
+        // Initial capacities per frame in flight, the upload buffers double whenever a frame needs more
+        constexpr size_t trianglePrimitiveCapacity = 1 << 14;
+        constexpr size_t linePointCapacity = 1 << 14;
+        constexpr size_t lineSegmentCapacity = 1 << 14;
+        constexpr size_t ellipseShapeCapacity = 1 << 12;
+        constexpr size_t spritePrimitiveCapacity = 1 << 14;
+
+        nvrhi::BufferDesc trianglePrimitiveDesc;
+        trianglePrimitiveDesc.canHaveRawViews = true;
+        trianglePrimitiveDesc.structStride = sizeof(TrianglePrimitiveData);
+        trianglePrimitiveDesc.debugName = "Renderer2D::TrianglePrimitiveBuffer";
+        trianglePrimitiveDesc.initialState = nvrhi::ResourceStates::ShaderResource;
+        mTriangleUpload.Primitives = FrameUploadBuffer<TrianglePrimitiveData>(
+            mDevice, trianglePrimitiveDesc, trianglePrimitiveCapacity, mFramesInFlight);
+
+        nvrhi::BufferDesc linePointDesc;
+        linePointDesc.canHaveRawViews = true;
+        linePointDesc.structStride = sizeof(LinePointData);
+        linePointDesc.debugName = "Renderer2D::LinePointBuffer";
+        linePointDesc.initialState = nvrhi::ResourceStates::ShaderResource;
+        mLineUpload.Points = FrameUploadBuffer<LinePointData>(
+            mDevice, linePointDesc, linePointCapacity, mFramesInFlight);
+
+        nvrhi::BufferDesc lineSegmentDesc;
+        lineSegmentDesc.canHaveRawViews = true;
+        lineSegmentDesc.structStride = sizeof(LineSegmentData);
+        lineSegmentDesc.debugName = "Renderer2D::LineSegmentBuffer";
+        lineSegmentDesc.initialState = nvrhi::ResourceStates::ShaderResource;
+        mLineUpload.Segments = FrameUploadBuffer<LineSegmentData>(
+            mDevice, lineSegmentDesc, lineSegmentCapacity, mFramesInFlight);
+
+        nvrhi::BufferDesc ellipseShapeDesc;
+        ellipseShapeDesc.canHaveRawViews = true;
+        ellipseShapeDesc.structStride = sizeof(EllipseShapeData);
+        ellipseShapeDesc.debugName = "Renderer2D::EllipseShapeBuffer";
+        ellipseShapeDesc.initialState = nvrhi::ResourceStates::ShaderResource;
+        mEllipseUpload.Shapes = FrameUploadBuffer<EllipseShapeData>(
+            mDevice, ellipseShapeDesc, ellipseShapeCapacity, mFramesInFlight);
+
+        nvrhi::BufferDesc spritePrimitiveDesc;
+        spritePrimitiveDesc.canHaveRawViews = true;
+        spritePrimitiveDesc.structStride = sizeof(SpritePrimitiveData);
+        spritePrimitiveDesc.debugName = "Renderer2D::SpritePrimitiveBuffer";
+        spritePrimitiveDesc.initialState = nvrhi::ResourceStates::ShaderResource;
+        mSpriteUpload.Primitives = FrameUploadBuffer<SpritePrimitiveData>(
+            mDevice, spritePrimitiveDesc, spritePrimitiveCapacity, mFramesInFlight);
+
+        mFrameResources.resize(mFramesInFlight);
+        for (auto &frame: mFrameResources) {
+            frame.CompletionQuery = mDevice->createEventQuery();
         }
     }
 
@@ -233,35 +353,58 @@ Engine {
         CreatePipelineTriangle();
         CreatePipelineLine();
         CreatePipelineEllipse();
+        CreatePipelineSprite();
+        CreatePipelineClipStencil();
     }
 
     void Renderer2D::CreateConstantBuffers() {
+        // Volatile so static batches can bind their own transform with the same pipelines. A version is held
+        // until the frame that wrote it completes.
+        const uint32_t frameVersions = mFramesInFlight + 1;
+
         nvrhi::BufferDesc constBufferVPMatrixDesc;
         constBufferVPMatrixDesc.byteSize = sizeof(glm::mat4);
         constBufferVPMatrixDesc.isConstantBuffer = true;
+        constBufferVPMatrixDesc.isVolatile = true;
+        constBufferVPMatrixDesc.maxVersions = frameVersions;
         constBufferVPMatrixDesc.debugName = "Renderer2D::ConstantBufferVPMatrix";
-        constBufferVPMatrixDesc.initialState = nvrhi::ResourceStates::ShaderResource |
-                                               nvrhi::ResourceStates::ConstantBuffer;
-        constBufferVPMatrixDesc.keepInitialState = true;
         mTriangleConstantBuffer = mDevice->createBuffer(constBufferVPMatrixDesc);
 
         nvrhi::BufferDesc constBufferLineDesc;
-        constBufferLineDesc.byteSize = sizeof(glm::mat4);
+        constBufferLineDesc.byteSize = sizeof(LineConstants);
         constBufferLineDesc.isConstantBuffer = true;
+        constBufferLineDesc.isVolatile = true;
+        constBufferLineDesc.maxVersions = frameVersions;
         constBufferLineDesc.debugName = "Renderer2D::LineConstantBufferVPMatrix";
-        constBufferLineDesc.initialState = nvrhi::ResourceStates::ShaderResource |
-                                           nvrhi::ResourceStates::ConstantBuffer;
-        constBufferLineDesc.keepInitialState = true;
         mLineConstantBuffer = mDevice->createBuffer(constBufferLineDesc);
 
         nvrhi::BufferDesc constBufferEllipseDesc;
         constBufferEllipseDesc.byteSize = sizeof(glm::mat4);
         constBufferEllipseDesc.isConstantBuffer = true;
+        constBufferEllipseDesc.isVolatile = true;
+        constBufferEllipseDesc.maxVersions = frameVersions;
         constBufferEllipseDesc.debugName = "Renderer2D::EllipseConstantBufferVPMatrix";
-        constBufferEllipseDesc.initialState = nvrhi::ResourceStates::ShaderResource |
-                                              nvrhi::ResourceStates::ConstantBuffer;
-        constBufferEllipseDesc.keepInitialState = true;
         mEllipseConstantBuffer = mDevice->createBuffer(constBufferEllipseDesc);
+
+        nvrhi::BufferDesc constBufferSpriteDesc;
+        constBufferSpriteDesc.byteSize = sizeof(glm::mat4);
+        constBufferSpriteDesc.isConstantBuffer = true;
+        constBufferSpriteDesc.isVolatile = true;
+        constBufferSpriteDesc.maxVersions = frameVersions;
+        constBufferSpriteDesc.debugName = "Renderer2D::SpriteConstantBufferVPMatrix";
+        mSpriteConstantBuffer = mDevice->createBuffer(constBufferSpriteDesc);
+
+        // Written once per static batch draw and pass
+        constexpr uint32_t staticBatchDrawsPerFrame = 2048;
+
+        // Laid out as LineConstants, which starts with the matrix every other pipeline reads
+        nvrhi::BufferDesc constBufferStaticBatchDesc;
+        constBufferStaticBatchDesc.byteSize = sizeof(LineConstants);
+        constBufferStaticBatchDesc.isConstantBuffer = true;
+        constBufferStaticBatchDesc.isVolatile = true;
+        constBufferStaticBatchDesc.maxVersions = staticBatchDrawsPerFrame * frameVersions;
+        constBufferStaticBatchDesc.debugName = "Renderer2D::StaticBatchConstantBufferVPMatrix";
+        mStaticBatchConstantBuffer = mDevice->createBuffer(constBufferStaticBatchDesc);
     }
 
     void Renderer2D::CreatePipelineTriangle() {
@@ -272,58 +415,27 @@ Engine {
                                                        GeneratedShaders::renderer2d_triangle_vs.data(),
                                                        GeneratedShaders::renderer2d_triangle_vs.size());
 
-        nvrhi::ShaderDesc psDesc;
-        psDesc.shaderType = nvrhi::ShaderType::Pixel;
-        psDesc.entryName = "main";
-        nvrhi::ShaderHandle ps = mDevice->createShader(psDesc,
-                                                       GeneratedShaders::renderer2d_triangle_ps.data(),
-                                                       GeneratedShaders::renderer2d_triangle_ps.size());
-
-        nvrhi::VertexAttributeDesc posAttrs[3];
-        posAttrs[0].name = "POSITION";
-        posAttrs[0].format = nvrhi::Format::RG32_FLOAT;
-        posAttrs[0].bufferIndex = 0;
-        posAttrs[0].offset = offsetof(TriangleVertexData, Position);
-        posAttrs[0].elementStride = sizeof(TriangleVertexData);
-
-        posAttrs[1].name = "TEXCOORD";
-        posAttrs[1].format = nvrhi::Format::RG32_FLOAT;
-        posAttrs[1].bufferIndex = 0;
-        posAttrs[1].offset = offsetof(TriangleVertexData, TexCoords);
-        posAttrs[1].elementStride = sizeof(TriangleVertexData);
-
-        posAttrs[2].name = "CONSTANTINDEX";
-        posAttrs[2].format = nvrhi::Format::R32_UINT;
-        posAttrs[2].bufferIndex = 0;
-        posAttrs[2].offset = offsetof(TriangleVertexData, InstanceIndex);
-        posAttrs[2].elementStride = sizeof(TriangleVertexData);
-
-        mTriangleInputLayout = mDevice->createInputLayout(posAttrs, 3, vs);
-
-        nvrhi::BindingLayoutDesc bindingLayoutDesc[2];
-        bindingLayoutDesc[0].visibility = nvrhi::ShaderType::Vertex | nvrhi::ShaderType::Pixel;
-        bindingLayoutDesc[0].bindings = {
-            nvrhi::BindingLayoutItem::ConstantBuffer(0),
-            nvrhi::BindingLayoutItem::StructuredBuffer_SRV(0),
-            nvrhi::BindingLayoutItem::StructuredBuffer_SRV(1),
-            nvrhi::BindingLayoutItem::Sampler(0)
+        const PixelShaderPermutations pixelShaders{
+            CreatePixelShader(mDevice, GeneratedShaders::renderer2d_triangle_ps),
+            CreatePixelShader(mDevice, GeneratedShaders::renderer2d_triangle_ps_textured)
         };
 
-        bindingLayoutDesc[1].visibility = nvrhi::ShaderType::Pixel;
-        bindingLayoutDesc[1].bindings = {
-            nvrhi::BindingLayoutItem::Texture_SRV(0).setSize(mBindlessTextureArraySizeMax)
+        nvrhi::BindingLayoutDesc bindingLayoutDesc;
+        bindingLayoutDesc.visibility = nvrhi::ShaderType::Vertex | nvrhi::ShaderType::Pixel;
+        bindingLayoutDesc.bindings = {
+            nvrhi::BindingLayoutItem::VolatileConstantBuffer(0),
+            nvrhi::BindingLayoutItem::PushConstants(1, sizeof(DepthConstants)),
+            nvrhi::BindingLayoutItem::StructuredBuffer_SRV(0),
+            nvrhi::BindingLayoutItem::Sampler(0)
         };
 
-        mTriangleBindingLayoutSpace0 = mDevice->createBindingLayout(bindingLayoutDesc[0]);
-        mTriangleBindingLayoutSpace1 = mDevice->createBindingLayout(bindingLayoutDesc[1]);
+        mTriangleBindingLayoutSpace0 = mDevice->createBindingLayout(bindingLayoutDesc);
 
         nvrhi::GraphicsPipelineDesc pipeDesc;
         pipeDesc.VS = vs;
-        pipeDesc.PS = ps;
-        pipeDesc.inputLayout = mTriangleInputLayout;
         pipeDesc.bindingLayouts = {
             mTriangleBindingLayoutSpace0,
-            mTriangleBindingLayoutSpace1
+            mVirtualTextureManager.GetBindingLayout()
         };
 
         pipeDesc.primType = nvrhi::PrimitiveType::TriangleList;
@@ -335,9 +447,8 @@ Engine {
         pipeDesc.renderState.blendState.targets[0].destBlendAlpha = nvrhi::BlendFactor::InvSrcAlpha;
         pipeDesc.renderState.blendState.targets[0].colorWriteMask = nvrhi::ColorMask::All;
         pipeDesc.renderState.rasterState.cullMode = nvrhi::RasterCullMode::None;
-        pipeDesc.renderState.depthStencilState.depthTestEnable = false;
 
-        mTrianglePipeline = mDevice->createGraphicsPipeline(pipeDesc, mFramebuffer->getFramebufferInfo());
+        CreatePipelineVariants(pipeDesc, mTrianglePipelines, pixelShaders, true);
     }
 
     void Renderer2D::CreatePipelineLine() {
@@ -348,45 +459,27 @@ Engine {
                                                        GeneratedShaders::renderer2d_line_vs.data(),
                                                        GeneratedShaders::renderer2d_line_vs.size());
 
-        nvrhi::ShaderDesc psDesc;
-        psDesc.shaderType = nvrhi::ShaderType::Pixel;
-        psDesc.entryName = "main";
-        nvrhi::ShaderHandle ps = mDevice->createShader(psDesc,
-                                                       GeneratedShaders::renderer2d_line_ps.data(),
-                                                       GeneratedShaders::renderer2d_line_ps.size());
-
-        nvrhi::VertexAttributeDesc posAttrs[2];
-        posAttrs[0].name = "POSITION";
-        posAttrs[0].format = nvrhi::Format::RG32_FLOAT;
-        posAttrs[0].bufferIndex = 0;
-        posAttrs[0].offset = offsetof(LineVertexData, Position);
-        posAttrs[0].elementStride = sizeof(LineVertexData);
-
-        posAttrs[1].name = "COLOR";
-        posAttrs[1].format = nvrhi::Format::R32_UINT;
-        posAttrs[1].bufferIndex = 0;
-        posAttrs[1].offset = offsetof(LineVertexData, Color);
-        posAttrs[1].elementStride = sizeof(LineVertexData);
-
-        mLineInputLayout = mDevice->createInputLayout(posAttrs, 2, vs);
+        // Lines have no texture, only the plain permutation exists
+        const PixelShaderPermutations pixelShaders{CreatePixelShader(mDevice, GeneratedShaders::renderer2d_line_ps)};
 
         nvrhi::BindingLayoutDesc bindingLayoutDesc;
-        bindingLayoutDesc.visibility = nvrhi::ShaderType::Vertex;
+        bindingLayoutDesc.visibility = nvrhi::ShaderType::Vertex | nvrhi::ShaderType::Pixel;
         bindingLayoutDesc.bindings = {
-            nvrhi::BindingLayoutItem::ConstantBuffer(0)
+            nvrhi::BindingLayoutItem::VolatileConstantBuffer(0),
+            nvrhi::BindingLayoutItem::PushConstants(1, sizeof(DepthConstants)),
+            nvrhi::BindingLayoutItem::StructuredBuffer_SRV(0),
+            nvrhi::BindingLayoutItem::StructuredBuffer_SRV(1)
         };
 
         mLineBindingLayoutSpace0 = mDevice->createBindingLayout(bindingLayoutDesc);
 
         nvrhi::GraphicsPipelineDesc pipeDesc;
         pipeDesc.VS = vs;
-        pipeDesc.PS = ps;
-        pipeDesc.inputLayout = mLineInputLayout;
         pipeDesc.bindingLayouts = {
             mLineBindingLayoutSpace0
         };
 
-        pipeDesc.primType = nvrhi::PrimitiveType::LineList;
+        pipeDesc.primType = nvrhi::PrimitiveType::TriangleList;
 
         pipeDesc.renderState.blendState.targets[0].blendEnable = true;
         pipeDesc.renderState.blendState.targets[0].srcBlend = nvrhi::BlendFactor::SrcAlpha;
@@ -395,9 +488,8 @@ Engine {
         pipeDesc.renderState.blendState.targets[0].destBlendAlpha = nvrhi::BlendFactor::InvSrcAlpha;
         pipeDesc.renderState.blendState.targets[0].colorWriteMask = nvrhi::ColorMask::All;
         pipeDesc.renderState.rasterState.cullMode = nvrhi::RasterCullMode::None;
-        pipeDesc.renderState.depthStencilState.depthTestEnable = false;
 
-        mLinePipeline = mDevice->createGraphicsPipeline(pipeDesc, mFramebuffer->getFramebufferInfo());
+        CreatePipelineVariants(pipeDesc, mLinePipelines, pixelShaders, false);
     }
 
     void Renderer2D::CreatePipelineEllipse() {
@@ -408,36 +500,27 @@ Engine {
                                                        GeneratedShaders::renderer2d_ellipse_vs.data(),
                                                        GeneratedShaders::renderer2d_ellipse_vs.size());
 
-        nvrhi::ShaderDesc psDesc;
-        psDesc.shaderType = nvrhi::ShaderType::Pixel;
-        psDesc.entryName = "main";
-        nvrhi::ShaderHandle ps = mDevice->createShader(psDesc,
-                                                       GeneratedShaders::renderer2d_ellipse_ps.data(),
-                                                       GeneratedShaders::renderer2d_ellipse_ps.size());
-
-        nvrhi::BindingLayoutDesc bindingLayoutDesc[2];
-        bindingLayoutDesc[0].visibility = nvrhi::ShaderType::Vertex | nvrhi::ShaderType::Pixel;
-        bindingLayoutDesc[0].bindings = {
-            nvrhi::BindingLayoutItem::ConstantBuffer(0),
-            nvrhi::BindingLayoutItem::StructuredBuffer_SRV(0),
-            nvrhi::BindingLayoutItem::StructuredBuffer_SRV(1),
-            nvrhi::BindingLayoutItem::Sampler(0)
+        const PixelShaderPermutations pixelShaders{
+            CreatePixelShader(mDevice, GeneratedShaders::renderer2d_ellipse_ps),
+            CreatePixelShader(mDevice, GeneratedShaders::renderer2d_ellipse_ps_textured)
         };
 
-        bindingLayoutDesc[1].visibility = nvrhi::ShaderType::Pixel;
-        bindingLayoutDesc[1].bindings = {
-            nvrhi::BindingLayoutItem::Texture_SRV(0).setSize(mBindlessTextureArraySizeMax)
+        nvrhi::BindingLayoutDesc bindingLayoutDesc;
+        bindingLayoutDesc.visibility = nvrhi::ShaderType::Vertex | nvrhi::ShaderType::Pixel;
+        bindingLayoutDesc.bindings = {
+            nvrhi::BindingLayoutItem::VolatileConstantBuffer(0),
+            nvrhi::BindingLayoutItem::PushConstants(1, sizeof(DepthConstants)),
+            nvrhi::BindingLayoutItem::StructuredBuffer_SRV(0),
+            nvrhi::BindingLayoutItem::Sampler(0)
         };
 
-        mEllipseBindingLayoutSpace0 = mDevice->createBindingLayout(bindingLayoutDesc[0]);
-        mEllipseBindingLayoutSpace1 = mDevice->createBindingLayout(bindingLayoutDesc[1]);
+        mEllipseBindingLayoutSpace0 = mDevice->createBindingLayout(bindingLayoutDesc);
 
         nvrhi::GraphicsPipelineDesc pipeDesc;
         pipeDesc.VS = vs;
-        pipeDesc.PS = ps;
         pipeDesc.bindingLayouts = {
             mEllipseBindingLayoutSpace0,
-            mEllipseBindingLayoutSpace1
+            mVirtualTextureManager.GetBindingLayout()
         };
 
         pipeDesc.primType = nvrhi::PrimitiveType::TriangleList;
@@ -449,195 +532,859 @@ Engine {
         pipeDesc.renderState.blendState.targets[0].destBlendAlpha = nvrhi::BlendFactor::InvSrcAlpha;
         pipeDesc.renderState.blendState.targets[0].colorWriteMask = nvrhi::ColorMask::All;
         pipeDesc.renderState.rasterState.cullMode = nvrhi::RasterCullMode::None;
-        pipeDesc.renderState.depthStencilState.depthTestEnable = false;
 
-        mEllipsePipeline = mDevice->createGraphicsPipeline(pipeDesc, mFramebuffer->getFramebufferInfo());
+        CreatePipelineVariants(pipeDesc, mEllipsePipelines, pixelShaders, false);
     }
 
-    void Renderer2D::SubmitTriangleBatchRendering() {
-        auto submissions = mTriangleCommandList.RecordRendererSubmissionData(
-            mTriangleBufferInstanceSizeMax);
+    void Renderer2D::CreatePipelineSprite() {
+        nvrhi::ShaderDesc vsDesc;
+        vsDesc.shaderType = nvrhi::ShaderType::Vertex;
+        vsDesc.entryName = "main";
+        nvrhi::ShaderHandle vs = mDevice->createShader(vsDesc,
+                                                       GeneratedShaders::renderer2d_sprite_vs.data(),
+                                                       GeneratedShaders::renderer2d_sprite_vs.size());
 
-        CreateTriangleBatchRenderingResources(submissions.size());
+        // The sprite vertex shader emits the triangle pixel shader's inputs
+        const PixelShaderPermutations pixelShaders{
+            CreatePixelShader(mDevice, GeneratedShaders::renderer2d_triangle_ps),
+            CreatePixelShader(mDevice, GeneratedShaders::renderer2d_triangle_ps_textured)
+        };
 
-        // submit constant buffer
-        mCommandList->writeBuffer(mTriangleConstantBuffer, &mViewProjectionMatrix,
-                                  sizeof(glm::mat4), 0);
+        nvrhi::GraphicsPipelineDesc pipeDesc;
+        pipeDesc.VS = vs;
+        pipeDesc.bindingLayouts = {
+            mTriangleBindingLayoutSpace0,
+            mVirtualTextureManager.GetBindingLayout()
+        };
 
-        for (size_t i = 0; i < submissions.size(); ++i) {
-            auto &submission = submissions[i];
-            auto &resources = mTriangleBatchRenderingResources[i];
+        pipeDesc.primType = nvrhi::PrimitiveType::TriangleList;
 
-            // Update Buffers
-            if (!submission.VertexData.empty()) {
-                mCommandList->writeBuffer(resources.VertexBuffer, submission.VertexData.data(),
-                                          sizeof(TriangleVertexData) * submission.VertexData.size(), 0);
-            }
+        pipeDesc.renderState.blendState.targets[0].blendEnable = true;
+        pipeDesc.renderState.blendState.targets[0].srcBlend = nvrhi::BlendFactor::SrcAlpha;
+        pipeDesc.renderState.blendState.targets[0].destBlend = nvrhi::BlendFactor::InvSrcAlpha;
+        pipeDesc.renderState.blendState.targets[0].srcBlendAlpha = nvrhi::BlendFactor::One;
+        pipeDesc.renderState.blendState.targets[0].destBlendAlpha = nvrhi::BlendFactor::InvSrcAlpha;
+        pipeDesc.renderState.blendState.targets[0].colorWriteMask = nvrhi::ColorMask::All;
+        pipeDesc.renderState.rasterState.cullMode = nvrhi::RasterCullMode::None;
 
-            if (!submission.IndexData.empty()) {
-                mCommandList->writeBuffer(resources.IndexBuffer, submission.IndexData.data(),
-                                          sizeof(uint32_t) * submission.IndexData.size(), 0);
-            }
+        CreatePipelineVariants(pipeDesc, mSpritePipelines, pixelShaders, true);
+    }
 
-            if (!submission.InstanceData.empty()) {
-                mCommandList->writeBuffer(resources.InstanceBuffer, submission.InstanceData.data(),
-                                          sizeof(TriangleInstanceData) * submission.InstanceData.size(), 0);
-            }
+    void Renderer2D::CreatePipelineClipStencil() {
+        nvrhi::ShaderDesc vsDesc;
+        vsDesc.shaderType = nvrhi::ShaderType::Vertex;
+        vsDesc.entryName = "main";
+        nvrhi::ShaderHandle vs = mDevice->createShader(vsDesc,
+                                                       GeneratedShaders::renderer2d_clip_vs.data(),
+                                                       GeneratedShaders::renderer2d_clip_vs.size());
+
+        // The clip's points arrive as push constants, already in clip space
+        nvrhi::BindingLayoutDesc bindingLayoutDesc;
+        bindingLayoutDesc.visibility = nvrhi::ShaderType::Vertex;
+        bindingLayoutDesc.bindings = {
+            nvrhi::BindingLayoutItem::PushConstants(0, sizeof(glm::mat4x2))
+        };
+        mClipStencilBindingLayout = mDevice->createBindingLayout(bindingLayoutDesc);
+
+        nvrhi::BindingSetDesc bindingSetDesc;
+        bindingSetDesc.addItem(nvrhi::BindingSetItem::PushConstants(0, sizeof(glm::mat4x2)));
+        mClipStencilBindingSet = mDevice->createBindingSet(bindingSetDesc, mClipStencilBindingLayout);
 
-            if (!submission.ClipData.empty()) {
-                mCommandList->writeBuffer(resources.ClipBuffer, submission.ClipData.data(),
-                                          sizeof(ClipRegion) * submission.ClipData.size(), 0);
+        // No pixel shader and no color writes. The fan is drawn twice: first it inverts the parity bit of every
+        // pixel it covers, which leaves the bit set exactly inside the polygon under the even-odd rule, concave
+        // and self-intersecting clips included. Then pixels with the bit set take the reference value, which also
+        // clears the bit again for the next clip.
+        nvrhi::GraphicsPipelineDesc pipeDesc;
+        pipeDesc.VS = vs;
+        pipeDesc.bindingLayouts = {mClipStencilBindingLayout};
+        pipeDesc.primType = nvrhi::PrimitiveType::TriangleList;
+
+        pipeDesc.renderState.blendState.targets[0].colorWriteMask = nvrhi::ColorMask::None;
+        pipeDesc.renderState.rasterState.cullMode = nvrhi::RasterCullMode::None;
+
+        auto &depthStencil = pipeDesc.renderState.depthStencilState;
+        depthStencil.depthTestEnable = false;
+        depthStencil.depthWriteEnable = false;
+        depthStencil.stencilEnable = true;
+        depthStencil.dynamicStencilRef = true;
+
+        nvrhi::StencilOpDesc invert;
+        invert.passOp = nvrhi::StencilOp::Invert;
+        invert.stencilFunc = nvrhi::ComparisonFunc::Always;
+        depthStencil.stencilWriteMask = ClipStencilParityBit;
+        depthStencil.frontFaceStencil = invert;
+        depthStencil.backFaceStencil = invert;
+        mClipStencilParityPipeline = mDevice->createGraphicsPipeline(pipeDesc, mFramebuffer->getFramebufferInfo());
+
+        // References never have the parity bit, so they differ from the stored value in it exactly where it is set
+        nvrhi::StencilOpDesc resolve;
+        resolve.passOp = nvrhi::StencilOp::Replace;
+        resolve.stencilFunc = nvrhi::ComparisonFunc::NotEqual;
+        depthStencil.stencilReadMask = ClipStencilParityBit;
+        depthStencil.stencilWriteMask = 0xFF;
+        depthStencil.frontFaceStencil = resolve;
+        depthStencil.backFaceStencil = resolve;
+        mClipStencilResolvePipeline = mDevice->createGraphicsPipeline(pipeDesc, mFramebuffer->getFramebufferInfo());
+    }
+
+    void Renderer2D::CreatePipelineVariants(nvrhi::GraphicsPipelineDesc desc, PipelineVariants &variants,
+                                            const PixelShaderPermutations &pixelShaders, bool hasOpaqueDraws) {
+        desc.renderState.rasterState.scissorEnable = true;
+
+        // Every primitive has its own depth value, so a strict test never hides one behind itself
+        auto &depthStencil = desc.renderState.depthStencilState;
+        depthStencil.depthTestEnable = true;
+        depthStencil.depthFunc = nvrhi::ComparisonFunc::Less;
+        depthStencil.stencilReadMask = 0xFF;
+        depthStencil.stencilWriteMask = 0;
+        depthStencil.dynamicStencilRef = true;
+
+        for (size_t permutation = 0; permutation < variants.size(); ++permutation) {
+            if (!pixelShaders[permutation]) {
+                continue;
             }
+            desc.PS = pixelShaders[permutation];
 
+            for (size_t pass = 0; pass < variants[permutation].size(); ++pass) {
+                const bool opaque = static_cast<DrawPass>(pass) == DrawPass::Opaque;
+                if (opaque && !hasOpaqueDraws) {
+                    continue;
+                }
 
-            mCommandList->setResourceStatesForBindingSet(resources.mBindingSetSpace0);
-            auto bindingSetSpace1 = mVirtualTextureManager.GetBindingSet(mTriangleBindingLayoutSpace1);
-            mCommandList->setResourceStatesForBindingSet(bindingSetSpace1);
+                // Opaque draws replace what is below them, blending would only cost bandwidth
+                desc.renderState.blendState.targets[0].blendEnable = !opaque;
+                depthStencil.depthWriteEnable = opaque;
 
-            // Draw Call
-            nvrhi::GraphicsState state;
-            state.pipeline = mTrianglePipeline;
-            state.framebuffer = mFramebuffer;
-            state.viewport.addViewportAndScissorRect(
-                mFramebuffer->getFramebufferInfo().getViewport());
-            state.bindings.push_back(resources.mBindingSetSpace0);
-            state.bindings.push_back(bindingSetSpace1);
+                for (size_t i = 0; i < variants[permutation][pass].size(); ++i) {
+                    const auto test = static_cast<ClipStencilTest>(i);
 
-            nvrhi::VertexBufferBinding vertexBufferBinding;
-            vertexBufferBinding.buffer = resources.VertexBuffer;
-            vertexBufferBinding.offset = 0;
-            vertexBufferBinding.slot = 0;
+                    nvrhi::StencilOpDesc stencilOp;
+                    stencilOp.stencilFunc = test == ClipStencilTest::Outside
+                                                ? nvrhi::ComparisonFunc::NotEqual
+                                                : nvrhi::ComparisonFunc::Equal;
+                    depthStencil.stencilEnable = test != ClipStencilTest::None;
+                    depthStencil.frontFaceStencil = stencilOp;
+                    depthStencil.backFaceStencil = stencilOp;
+
+                    variants[permutation][pass][i] = mDevice->createGraphicsPipeline(
+                        desc, mFramebuffer->getFramebufferInfo());
+                }
+            }
+        }
+    }
 
-            state.vertexBuffers.push_back(vertexBufferBinding);
+    void Renderer2D::PrepareTriangleRendering() {
+        mStatistics.CulledPrimitives += static_cast<uint32_t>(mTriangleCommandList.Cull(mVisibleBounds));
+        mTriangleCommandList.RecordRendererSubmissionData(mTriangleUpload, mSubmissionThreadPool);
+        AddCoveredArea(mStatistics, CoveredArea(mTriangleCommandList.SortKeys, mTriangleCommandList.Bounds,
+                                                mVisibleBounds));
 
-            nvrhi::IndexBufferBinding indexBufferBinding;
-            indexBufferBinding.buffer = resources.IndexBuffer;
-            indexBufferBinding.format = nvrhi::Format::R32_UINT;
-            indexBufferBinding.offset = 0;
+        if (mTriangleCommandList.Segments.empty()) {
+            return;
+        }
 
-            state.indexBuffer = indexBufferBinding;
+        // submit constant buffer
+        mCommandList->writeBuffer(mTriangleConstantBuffer, &mViewProjectionMatrix,
+                                  sizeof(glm::mat4), 0);
 
-            mCommandList->setGraphicsState(state);
+        for (const auto &segment: mTriangleCommandList.Segments) {
+            mDrawStream.push_back({
+                .Depth = segment.Depth,
+                .Type = PrimitiveType::Triangle,
+                .First = segment.First,
+                .Count = segment.Count,
+                .Clip = InternSegmentClip(mFrameClips, mTriangleCommandList.Clips, segment.Clip),
+                .Opaque = segment.Opaque,
+                .Textured = segment.Textured
+            });
+        }
+    }
 
-            nvrhi::DrawArguments drawArgs;
-            drawArgs.vertexCount = static_cast<uint32_t>(submission.IndexData.size());
+    void Renderer2D::PrepareLineRendering() {
+        mStatistics.CulledPrimitives += static_cast<uint32_t>(mLineCommandList.Cull(mVisibleBounds));
+        mLineCommandList.RecordRendererSubmissionData(mLineUpload, mSubmissionThreadPool);
 
-            mCommandList->drawIndexed(drawArgs);
+        if (mLineCommandList.Segments.empty()) {
+            return;
         }
 
-        mTriangleCommandList.GiveBackForNextFrame(std::move(submissions));
+        // submit constant buffer
+        LineConstants constants{.ViewProjection = mViewProjectionMatrix, .PixelSize = mPixelSize};
+        mCommandList->writeBuffer(mLineConstantBuffer, &constants, sizeof(LineConstants), 0);
+
+        for (const auto &segment: mLineCommandList.Segments) {
+            mDrawStream.push_back({
+                .Depth = segment.Depth,
+                .Type = PrimitiveType::Line,
+                .First = segment.First,
+                .Count = segment.Count,
+                .Clip = InternSegmentClip(mFrameClips, mLineCommandList.Clips, segment.Clip),
+                .Opaque = segment.Opaque,
+                .Textured = segment.Textured
+            });
+        }
     }
 
-    void Renderer2D::SubmitLineBatchRendering() {
-        auto submissions = mLineCommandList.RecordRendererSubmissionData(
-            mLineBufferVertexSizeMax);
+    void Renderer2D::PrepareEllipseRendering() {
+        mStatistics.CulledPrimitives += static_cast<uint32_t>(mEllipseCommandList.Cull(mVisibleBounds));
+        mEllipseCommandList.RecordRendererSubmissionData(mEllipseUpload, mSubmissionThreadPool);
+        AddCoveredArea(mStatistics, CoveredArea(mEllipseCommandList.SortKeys, mEllipseCommandList.Bounds,
+                                                mVisibleBounds));
 
-        if (submissions.empty()) {
+        if (mEllipseCommandList.Segments.empty()) {
             return;
         }
 
-        CreateLineBatchRenderingResources(submissions.size());
+        mCommandList->writeBuffer(mEllipseConstantBuffer, &mViewProjectionMatrix,
+                                  sizeof(glm::mat4), 0);
 
-        // submit constant buffer
-        mCommandList->writeBuffer(mLineConstantBuffer, &mViewProjectionMatrix,
+        for (const auto &segment: mEllipseCommandList.Segments) {
+            mDrawStream.push_back({
+                .Depth = segment.Depth,
+                .Type = PrimitiveType::Ellipse,
+                .First = segment.First,
+                .Count = segment.Count,
+                .Clip = InternSegmentClip(mFrameClips, mEllipseCommandList.Clips, segment.Clip),
+                .Opaque = segment.Opaque,
+                .Textured = segment.Textured
+            });
+        }
+    }
+
+    void Renderer2D::PrepareSpriteRendering() {
+        mStatistics.CulledPrimitives += static_cast<uint32_t>(mSpriteCommandList.Cull(mVisibleBounds));
+        mSpriteCommandList.RecordRendererSubmissionData(mSpriteUpload, mSubmissionThreadPool);
+        AddCoveredArea(mStatistics, CoveredArea(mSpriteCommandList.SortKeys, mSpriteCommandList.Bounds,
+                                                mVisibleBounds));
+
+        if (mSpriteCommandList.Segments.empty()) {
+            return;
+        }
+
+        mCommandList->writeBuffer(mSpriteConstantBuffer, &mViewProjectionMatrix,
                                   sizeof(glm::mat4), 0);
 
-        for (size_t i = 0; i < submissions.size(); ++i) {
-            auto &submission = submissions[i];
-            auto &resources = mLineBatchRenderingResources[i];
+        for (const auto &segment: mSpriteCommandList.Segments) {
+            mDrawStream.push_back({
+                .Depth = segment.Depth,
+                .Type = PrimitiveType::Sprite,
+                .First = segment.First,
+                .Count = segment.Count,
+                .Clip = InternSegmentClip(mFrameClips, mSpriteCommandList.Clips, segment.Clip),
+                .Opaque = segment.Opaque,
+                .Textured = segment.Textured
+            });
+        }
+    }
+
+    void Renderer2D::UpdateFrameBindingSets() {
+        auto &frame = mFrameResources[mFrameSlot];
+
+        nvrhi::IBuffer *trianglePrimitives = mTriangleUpload.Primitives.GetBuffer();
+        if (frame.TrianglePrimitiveBuffer != trianglePrimitives) {
+            nvrhi::BindingSetDesc bindingSetDesc;
+            bindingSetDesc.addItem(nvrhi::BindingSetItem::ConstantBuffer(0, mTriangleConstantBuffer));
+            bindingSetDesc.addItem(nvrhi::BindingSetItem::PushConstants(1, sizeof(DepthConstants)));
+            bindingSetDesc.addItem(nvrhi::BindingSetItem::StructuredBuffer_SRV(0, trianglePrimitives));
+            bindingSetDesc.addItem(nvrhi::BindingSetItem::Sampler(0, mTextureSampler));
+            frame.TriangleBindingSetSpace0 = mDevice->createBindingSet(bindingSetDesc, mTriangleBindingLayoutSpace0);
+            frame.TrianglePrimitiveBuffer = trianglePrimitives;
+        }
+
+        nvrhi::IBuffer *ellipseShapes = mEllipseUpload.Shapes.GetBuffer();
+        if (frame.EllipseShapeBuffer != ellipseShapes) {
+            nvrhi::BindingSetDesc bindingSetDesc;
+            bindingSetDesc.addItem(nvrhi::BindingSetItem::ConstantBuffer(0, mEllipseConstantBuffer));
+            bindingSetDesc.addItem(nvrhi::BindingSetItem::PushConstants(1, sizeof(DepthConstants)));
+            bindingSetDesc.addItem(nvrhi::BindingSetItem::StructuredBuffer_SRV(0, ellipseShapes));
+            bindingSetDesc.addItem(nvrhi::BindingSetItem::Sampler(0, mTextureSampler));
+            frame.EllipseBindingSetSpace0 = mDevice->createBindingSet(bindingSetDesc, mEllipseBindingLayoutSpace0);
+            frame.EllipseShapeBuffer = ellipseShapes;
+        }
+
+        nvrhi::IBuffer *spritePrimitives = mSpriteUpload.Primitives.GetBuffer();
+        if (frame.SpritePrimitiveBuffer != spritePrimitives) {
+            nvrhi::BindingSetDesc bindingSetDesc;
+            bindingSetDesc.addItem(nvrhi::BindingSetItem::ConstantBuffer(0, mSpriteConstantBuffer));
+            bindingSetDesc.addItem(nvrhi::BindingSetItem::PushConstants(1, sizeof(DepthConstants)));
+            bindingSetDesc.addItem(nvrhi::BindingSetItem::StructuredBuffer_SRV(0, spritePrimitives));
+            bindingSetDesc.addItem(nvrhi::BindingSetItem::Sampler(0, mTextureSampler));
+            frame.SpriteBindingSetSpace0 = mDevice->createBindingSet(bindingSetDesc, mTriangleBindingLayoutSpace0);
+            frame.SpritePrimitiveBuffer = spritePrimitives;
+        }
+
+        nvrhi::IBuffer *linePoints = mLineUpload.Points.GetBuffer();
+        nvrhi::IBuffer *lineSegments = mLineUpload.Segments.GetBuffer();
+        if (frame.LinePointBuffer != linePoints || frame.LineSegmentBuffer != lineSegments) {
+            nvrhi::BindingSetDesc bindingSetDesc;
+            bindingSetDesc.addItem(nvrhi::BindingSetItem::ConstantBuffer(0, mLineConstantBuffer));
+            bindingSetDesc.addItem(nvrhi::BindingSetItem::PushConstants(1, sizeof(DepthConstants)));
+            bindingSetDesc.addItem(nvrhi::BindingSetItem::StructuredBuffer_SRV(0, linePoints));
+            bindingSetDesc.addItem(nvrhi::BindingSetItem::StructuredBuffer_SRV(1, lineSegments));
+            frame.LineBindingSetSpace0 = mDevice->createBindingSet(bindingSetDesc, mLineBindingLayoutSpace0);
+            frame.LinePointBuffer = linePoints;
+            frame.LineSegmentBuffer = lineSegments;
+        }
+    }
+
+    void Renderer2D::PrepareStaticBatchRendering() {
+        for (size_t i = 0; i < mStaticDraws.size(); ++i) {
+            StaticBatch &batch = *mStaticDraws[i].Batch;
+
+            // Texture IDs baked into the batch are stale once one of its textures was evicted
+            bool texturesStale = std::ranges::any_of(batch.mTextureHandles, [&](VirtualTextureHandle handle) {
+                return !mVirtualTextureManager.IsValid(handle);
+            });
+            if (batch.mIsDirty || texturesStale) {
+                BuildStaticBatch(batch);
+            }
+            for (const auto &handle: batch.mTextureHandles) {
+                mVirtualTextureManager.MarkUsed(handle.Slot);
+            }
 
-            // Update Buffers
-            if (!submission.VertexData.empty()) {
-                mCommandList->writeBuffer(resources.VertexBuffer, submission.VertexData.data(),
-                                          sizeof(LineVertexData) * submission.VertexData.size(), 0);
-            } else {
+            if (batch.mDrawStream.empty()) {
                 continue;
             }
 
-            mCommandList->setResourceStatesForBindingSet(resources.mBindingSetSpace0);
+            // Off-screen instances are skipped as a whole, their content is never culled piecewise
+            const glm::mat4 &model = mStaticDraws[i].Model;
+            glm::vec2 min = glm::vec2(model * glm::vec4(batch.mBounds.x, batch.mBounds.y, 0.0f, 1.0f));
+            glm::vec2 max = min;
+            for (const glm::vec2 corner: {glm::vec2(batch.mBounds.z, batch.mBounds.y),
+                                          glm::vec2(batch.mBounds.x, batch.mBounds.w),
+                                          glm::vec2(batch.mBounds.z, batch.mBounds.w)}) {
+                const glm::vec2 transformed = glm::vec2(model * glm::vec4(corner, 0.0f, 1.0f));
+                min = glm::min(min, transformed);
+                max = glm::max(max, transformed);
+            }
+            if (min.x > mVisibleBounds.z || min.y > mVisibleBounds.w ||
+                max.x < mVisibleBounds.x || max.y < mVisibleBounds.y) {
+                ++mStatistics.CulledPrimitives;
+                continue;
+            }
+            AddCoveredArea(mStatistics, batch.mCoveredArea * glm::abs(glm::determinant(glm::mat2(model))));
 
-            // Draw Call
-            nvrhi::GraphicsState state;
-            state.pipeline = mLinePipeline;
-            state.framebuffer = mFramebuffer;
-            state.viewport.addViewportAndScissorRect(
-                mFramebuffer->getFramebufferInfo().getViewport());
-            state.bindings.push_back(resources.mBindingSetSpace0);
+            mDrawStream.push_back({
+                .Depth = mStaticDraws[i].Depth,
+                .Type = PrimitiveType::StaticBatch,
+                .First = static_cast<uint32_t>(i),
+                .Count = 1
+            });
+        }
+    }
 
-            nvrhi::VertexBufferBinding vertexBufferBinding;
-            vertexBufferBinding.buffer = resources.VertexBuffer;
-            vertexBufferBinding.offset = 0;
-            vertexBufferBinding.slot = 0;
+    void Renderer2D::BuildStaticBatch(StaticBatch &batch) {
+        // The batch keeps its batch-local texture IDs, the uploaded copy uses this renderer's
+        batch.mTextureHandles.resize(batch.mLocalTextures.GetCurrentSize());
+        std::vector<int32_t> textureRemap(batch.mTextureHandles.size());
+        for (uint32_t i = 0; i < textureRemap.size(); ++i) {
+            batch.mTextureHandles[i] = RegisterVirtualTexture(batch.mLocalTextures.GetTexture(i),
+                                                              batch.mLocalTextures.IsOpaque(i));
+            textureRemap[i] = static_cast<int32_t>(batch.mTextureHandles[i].Slot);
+        }
+        auto remapTextures = [&](std::vector<int32_t> &textureIDs) {
+            for (auto &textureID: textureIDs) {
+                if (textureID >= 0) {
+                    textureID = textureRemap[textureID];
+                }
+            }
+        };
 
-            state.vertexBuffers.push_back(vertexBufferBinding);
+        // Recorded into host-visible staging buffers, then copied once into GPU-local ones
+        auto structuredDesc = [](size_t stride, const char *debugName) {
+            nvrhi::BufferDesc desc;
+            desc.canHaveRawViews = true;
+            desc.structStride = static_cast<uint32_t>(stride);
+            desc.debugName = debugName;
+            return desc;
+        };
+        auto createBindingSet = [&](nvrhi::IBuffer *data, nvrhi::IBindingLayout *layout) {
+            nvrhi::BindingSetDesc bindingSetDesc;
+            bindingSetDesc.addItem(nvrhi::BindingSetItem::ConstantBuffer(0, mStaticBatchConstantBuffer));
+            bindingSetDesc.addItem(nvrhi::BindingSetItem::PushConstants(1, sizeof(DepthConstants)));
+            bindingSetDesc.addItem(nvrhi::BindingSetItem::StructuredBuffer_SRV(0, data));
+            bindingSetDesc.addItem(nvrhi::BindingSetItem::Sampler(0, mTextureSampler));
+            return mDevice->createBindingSet(bindingSetDesc, layout);
+        };
 
-            mCommandList->setGraphicsState(state);
+        batch.mBounds = glm::vec4(std::numeric_limits<float>::max(), std::numeric_limits<float>::max(),
+                                  std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest());
+        for (const auto *bounds: {&batch.mTriangleCommandList.Bounds, &batch.mLineCommandList.Bounds,
+                                  &batch.mEllipseCommandList.Bounds, &batch.mSpriteCommandList.Bounds}) {
+            for (const auto &elementBounds: *bounds) {
+                batch.mBounds = glm::vec4(glm::min(glm::vec2(batch.mBounds), glm::vec2(elementBounds)),
+                                          glm::max(glm::vec2(batch.mBounds.z, batch.mBounds.w),
+                                                   glm::vec2(elementBounds.z, elementBounds.w)));
+            }
+        }
+
+        batch.mDrawStream.clear();
+        batch.mClips.Clear();
+        batch.mCoveredArea = glm::vec2(0.0f);
+        auto appendSegments = [&](const std::vector<DrawSegment> &segments, const ClipRegionTable &clips,
+                                  PrimitiveType type) {
+            for (const auto &segment: segments) {
+                batch.mDrawStream.push_back({
+                    .Depth = segment.Depth,
+                    .Type = type,
+                    .First = segment.First,
+                    .Count = segment.Count,
+                    .Clip = InternSegmentClip(batch.mClips, clips, segment.Clip),
+                    .Opaque = segment.Opaque,
+                    .Textured = segment.Textured
+                });
+            }
+        };
+        // Not cut to any visible area, the instances scale it by their transform
+        const glm::vec4 unbounded(std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(),
+                                  std::numeric_limits<float>::max(), std::numeric_limits<float>::max());
+
+        {
+            TriangleRenderingCommandList triangles = batch.mTriangleCommandList;
+            remapTextures(triangles.TextureIDs);
+            TriangleFrameUploadBuffers staging{
+                CreateStagingBuffer<TrianglePrimitiveData>(mDevice, triangles.Size())
+            };
+            triangles.RecordRendererSubmissionData(staging, mSubmissionThreadPool);
+            batch.mCoveredArea += CoveredArea(triangles.SortKeys, triangles.Bounds, unbounded);
+
+            auto &buffers = batch.mPrimitives[static_cast<size_t>(PrimitiveType::Triangle)];
+            buffers.Data = CreateStaticBuffer(mDevice, mCommandList, staging.Primitives, structuredDesc(
+                sizeof(TrianglePrimitiveData), "Renderer2D::StaticBatchTrianglePrimitiveBuffer"));
+            buffers.BindingSetSpace0 = createBindingSet(buffers.Data, mTriangleBindingLayoutSpace0);
+            appendSegments(triangles.Segments, triangles.Clips, PrimitiveType::Triangle);
+        }
 
-            nvrhi::DrawArguments drawArgs;
-            drawArgs.vertexCount = static_cast<uint32_t>(submission.VertexData.size());
+        {
+            LineRenderingCommandList lines = batch.mLineCommandList;
+            LineFrameUploadBuffers staging{
+                CreateStagingBuffer<LinePointData>(mDevice, lines.Points.size() + lines.Size()),
+                CreateStagingBuffer<LineSegmentData>(mDevice, lines.Points.size())
+            };
+            lines.RecordRendererSubmissionData(staging, mSubmissionThreadPool);
 
-            mCommandList->draw(drawArgs);
+            auto &buffers = batch.mPrimitives[static_cast<size_t>(PrimitiveType::Line)];
+            buffers.Data = CreateStaticBuffer(mDevice, mCommandList, staging.Segments, structuredDesc(
+                sizeof(LineSegmentData), "Renderer2D::StaticBatchLineSegmentBuffer"));
+            buffers.Points = CreateStaticBuffer(mDevice, mCommandList, staging.Points, structuredDesc(
+                sizeof(LinePointData), "Renderer2D::StaticBatchLinePointBuffer"));
+
+            nvrhi::BindingSetDesc bindingSetDesc;
+            bindingSetDesc.addItem(nvrhi::BindingSetItem::ConstantBuffer(0, mStaticBatchConstantBuffer));
+            bindingSetDesc.addItem(nvrhi::BindingSetItem::PushConstants(1, sizeof(DepthConstants)));
+            bindingSetDesc.addItem(nvrhi::BindingSetItem::StructuredBuffer_SRV(0, buffers.Points));
+            bindingSetDesc.addItem(nvrhi::BindingSetItem::StructuredBuffer_SRV(1, buffers.Data));
+            buffers.BindingSetSpace0 = mDevice->createBindingSet(bindingSetDesc, mLineBindingLayoutSpace0);
+            appendSegments(lines.Segments, lines.Clips, PrimitiveType::Line);
         }
 
-        mLineCommandList.GiveBackForNextFrame(std::move(submissions));
-    }
+        {
+            EllipseRenderingCommandList ellipses = batch.mEllipseCommandList;
+            remapTextures(ellipses.TextureIDs);
+            EllipseFrameUploadBuffers staging{
+                CreateStagingBuffer<EllipseShapeData>(mDevice, ellipses.Size())
+            };
+            ellipses.RecordRendererSubmissionData(staging, mSubmissionThreadPool);
+            batch.mCoveredArea += CoveredArea(ellipses.SortKeys, ellipses.Bounds, unbounded);
+
+            auto &buffers = batch.mPrimitives[static_cast<size_t>(PrimitiveType::Ellipse)];
+            buffers.Data = CreateStaticBuffer(mDevice, mCommandList, staging.Shapes, structuredDesc(
+                sizeof(EllipseShapeData), "Renderer2D::StaticBatchEllipseShapeBuffer"));
+            buffers.BindingSetSpace0 = createBindingSet(buffers.Data, mEllipseBindingLayoutSpace0);
+            appendSegments(ellipses.Segments, ellipses.Clips, PrimitiveType::Ellipse);
+        }
 
-    void Renderer2D::SubmitEllipseBatchRendering() {
-        auto submissions = mEllipseCommandList.RecordRendererSubmissionData(
-            mEllipseBufferInstanceSizeMax);
+        {
+            SpriteRenderingCommandList sprites = batch.mSpriteCommandList;
+            remapTextures(sprites.TextureIDs);
+            SpriteFrameUploadBuffers staging{
+                CreateStagingBuffer<SpritePrimitiveData>(mDevice, sprites.Size())
+            };
+            sprites.RecordRendererSubmissionData(staging, mSubmissionThreadPool);
+            batch.mCoveredArea += CoveredArea(sprites.SortKeys, sprites.Bounds, unbounded);
+
+            auto &buffers = batch.mPrimitives[static_cast<size_t>(PrimitiveType::Sprite)];
+            buffers.Data = CreateStaticBuffer(mDevice, mCommandList, staging.Primitives, structuredDesc(
+                sizeof(SpritePrimitiveData), "Renderer2D::StaticBatchSpritePrimitiveBuffer"));
+            buffers.BindingSetSpace0 = createBindingSet(buffers.Data, mTriangleBindingLayoutSpace0);
+            appendSegments(sprites.Segments, sprites.Clips, PrimitiveType::Sprite);
+        }
 
-        if (submissions.empty()) {
-            return;
+        SortDrawStream(batch.mDrawStream);
+
+        // Ordinals are relative to the instance's first one, which is only known when it is drawn
+        batch.mPrimitiveCount = 0;
+        batch.mOpaquePrimitiveCount = 0;
+        for (auto &entry: batch.mDrawStream) {
+            entry.FirstOrdinal = batch.mPrimitiveCount;
+            batch.mPrimitiveCount += entry.Count;
+            batch.mOpaquePrimitiveCount += entry.Opaque ? entry.Count : 0;
         }
+        MergeDrawStream(batch.mDrawStream, mMergedDrawStream);
+        batch.mDrawStream = mMergedDrawStream;
 
-        CreateEllipseBatchRenderingResources(submissions.size());
+        batch.mIsDirty = false;
+        ++mStatistics.StaticBatchBuilds;
+    }
 
-        mCommandList->writeBuffer(mEllipseConstantBuffer, &mViewProjectionMatrix,
-                                  sizeof(glm::mat4), 0);
+    void Renderer2D::SortDrawStream(std::vector<DrawStreamEntry> &stream) {
+        // Every per-type list is already sorted by depth, so a stable sort on (depth, type) keeps the
+        // submission order inside each type
+        mDrawStreamKeys.clear();
+        for (size_t i = 0; i < stream.size(); ++i) {
+            uint64_t depthBits = static_cast<uint32_t>(stream[i].Depth) ^ 0x80000000u;
+            mDrawStreamKeys.push_back({
+                (depthBits << 32) | static_cast<uint32_t>(stream[i].Type), static_cast<uint32_t>(i)
+            });
+        }
+        RadixSort(mDrawStreamKeys, mDrawStreamKeyScratch);
 
-        for (size_t i = 0; i < submissions.size(); ++i) {
-            auto &submission = submissions[i];
-            auto &resources = mEllipseBatchRenderingResources[i];
+        mSortedDrawStream.clear();
+        for (const auto &key: mDrawStreamKeys) {
+            mSortedDrawStream.push_back(stream[key.Payload]);
+        }
+        stream.swap(mSortedDrawStream);
+    }
 
-            if (submission.ShapeData.empty()) {
+    void Renderer2D::AssignDrawOrdinals() {
+        uint32_t ordinal = 0;
+        for (auto &entry: mDrawStream) {
+            entry.FirstOrdinal = ordinal;
+            if (entry.Type != PrimitiveType::StaticBatch) {
+                ordinal += entry.Count;
+                mStatistics.OpaquePrimitives += entry.Opaque ? entry.Count : 0;
                 continue;
             }
 
-            mCommandList->writeBuffer(resources.ShapeBuffer, submission.ShapeData.data(),
-                                      sizeof(EllipseShapeData) * submission.ShapeData.size(), 0);
+            for (uint32_t i = entry.First; i < entry.First + entry.Count; ++i) {
+                StaticBatchDraw &draw = mStaticDraws[i];
+                draw.FirstOrdinal = ordinal;
+                ordinal += draw.Batch->mPrimitiveCount;
+                mStatistics.OpaquePrimitives += draw.Batch->mOpaquePrimitiveCount;
+            }
+        }
 
-            if (!submission.ClipData.empty()) {
-                mCommandList->writeBuffer(resources.ClipBuffer, submission.ClipData.data(),
-                                          sizeof(ClipRegion) * submission.ClipData.size(), 0);
+        // 24-bit depth resolves every ordinal of frames with fewer than 2^24 primitives
+        mOrdinalScale = 1.0f / static_cast<float>(ordinal + 1);
+    }
+
+    nvrhi::IBindingSet *Renderer2D::GetFrameBindingSet(PrimitiveType type) const {
+        const auto &frame = mFrameResources[mFrameSlot];
+        switch (type) {
+            case PrimitiveType::Triangle:
+                return frame.TriangleBindingSetSpace0;
+            case PrimitiveType::Line:
+                return frame.LineBindingSetSpace0;
+            case PrimitiveType::Ellipse:
+                return frame.EllipseBindingSetSpace0;
+            case PrimitiveType::Sprite:
+                return frame.SpriteBindingSetSpace0;
+            case PrimitiveType::StaticBatch:
+                break;
+        }
+        return nullptr;
+    }
+
+    void Renderer2D::BindPrimitive(PrimitiveType type, ShaderPermutation permutation, DrawPass pass,
+                                   nvrhi::IBindingSet *bindingSetSpace0, const ClipState &clip) {
+        const auto permutationIndex = static_cast<size_t>(permutation);
+        const auto passIndex = static_cast<size_t>(pass);
+        const auto variant = static_cast<size_t>(clip.StencilTest);
+
+        nvrhi::GraphicsState state;
+        state.framebuffer = mFramebuffer;
+        state.viewport.addViewport(mFramebuffer->getFramebufferInfo().getViewport());
+        state.viewport.addScissorRect(clip.Scissor);
+        state.dynamicStencilRefValue = clip.StencilReference;
+
+        mCommandList->setResourceStatesForBindingSet(bindingSetSpace0);
+        state.bindings.push_back(bindingSetSpace0);
+
+        switch (type) {
+            case PrimitiveType::Triangle:
+            case PrimitiveType::Sprite: {
+                const PipelineVariants &pipelines = type == PrimitiveType::Triangle ? mTrianglePipelines
+                                                                                    : mSpritePipelines;
+                state.pipeline = pipelines[permutationIndex][passIndex][variant];
+                state.bindings.push_back(mVirtualTextureManager.GetDescriptorTable());
+                break;
+            }
+            case PrimitiveType::Line:
+                state.pipeline = mLinePipelines[permutationIndex][passIndex][variant];
+                break;
+            case PrimitiveType::Ellipse: {
+                state.pipeline = mEllipsePipelines[permutationIndex][passIndex][variant];
+                state.bindings.push_back(mVirtualTextureManager.GetDescriptorTable());
+                break;
             }
+            case PrimitiveType::StaticBatch:
+                throw Engine::RuntimeException("Renderer2D: Static batches have no pipeline of their own.");
+        }
 
-            mCommandList->setResourceStatesForBindingSet(resources.mBindingSetSpace0);
-            auto bindingSetSpace1 = mVirtualTextureManager.GetBindingSet(mEllipseBindingLayoutSpace1);
-            mCommandList->setResourceStatesForBindingSet(bindingSetSpace1);
+        mCommandList->setGraphicsState(state);
+    }
 
-            nvrhi::GraphicsState state;
-            state.pipeline = mEllipsePipeline;
-            state.framebuffer = mFramebuffer;
-            state.viewport.addViewportAndScissorRect(
-                mFramebuffer->getFramebufferInfo().getViewport());
-            state.bindings.push_back(resources.mBindingSetSpace0);
-            state.bindings.push_back(bindingSetSpace1);
+    void Renderer2D::DrawPrimitives(const DrawStreamEntry &entry, nvrhi::IBindingSet *bindingSetSpace0,
+                                    const ClipState &clip, uint32_t ordinalBase) {
+        const DrawPass pass = entry.Opaque ? DrawPass::Opaque : DrawPass::Translucent;
+        const ShaderPermutation permutation = entry.Textured ? ShaderPermutation::Textured
+                                                             : ShaderPermutation::Plain;
+        if (mBoundType != entry.Type || mBoundPass != pass || mBoundPermutation != permutation ||
+            mBoundBindingSet != bindingSetSpace0 || mBoundClip != clip) {
+            if (mBoundType && (mBoundType != entry.Type || mBoundPass != pass || mBoundPermutation != permutation)) {
+                ++mStatistics.PipelineSwitches;
+            }
+            BindPrimitive(entry.Type, permutation, pass, bindingSetSpace0, clip);
+            mBoundType = entry.Type;
+            mBoundPass = pass;
+            mBoundPermutation = permutation;
+            mBoundBindingSet = bindingSetSpace0;
+            mBoundClip = clip;
+        }
 
-            mCommandList->setGraphicsState(state);
+        // The shaders add their primitive index, which starts at entry.First
+        const DepthConstants depth{
+            .OrdinalOffset = static_cast<int32_t>(ordinalBase + entry.FirstOrdinal) -
+                             static_cast<int32_t>(entry.First),
+            .OrdinalScale = mOrdinalScale
+        };
+        mCommandList->setPushConstants(&depth, sizeof(DepthConstants));
+
+        // Every primitive, line segments included, expands to 6 vertices, except ellipses which are strips of
+        // EllipseSegments quads. SV_VertexID includes the start location.
+        const uint32_t verticesPerPrimitive = entry.Type == PrimitiveType::Ellipse ? EllipseSegments * 6 : 6;
+        nvrhi::DrawArguments drawArgs;
+        drawArgs.vertexCount = entry.Count * verticesPerPrimitive;
+        drawArgs.startVertexLocation = entry.First * verticesPerPrimitive;
+        mCommandList->draw(drawArgs);
+
+        ++mStatistics.DrawCalls;
+        mStatistics.PlainDrawCalls += permutation == ShaderPermutation::Plain ? 1 : 0;
+    }
+
+    void Renderer2D::DrawStaticBatchInstance(const StaticBatchDraw &draw, DrawPass pass) {
+        const StaticBatch &batch = *draw.Batch;
 
-            nvrhi::DrawArguments drawArgs;
-            drawArgs.vertexCount = static_cast<uint32_t>(submission.ShapeData.size() * 6);
+        // Line widths are in batch units, the pixel size follows the transform's scale
+        const float scale = glm::sqrt(glm::abs(glm::determinant(glm::mat2(draw.Model))));
+        LineConstants constants{
+            .ViewProjection = mViewProjectionMatrix * draw.Model,
+            .PixelSize = scale > 0.0f ? mPixelSize / scale : mPixelSize
+        };
+        mCommandList->writeBuffer(mStaticBatchConstantBuffer, &constants, sizeof(LineConstants), 0);
+
+        // A new constant buffer version only takes effect with the next setGraphicsState
+        mBoundBindingSet = nullptr;
+
+        auto drawEntry = [&](const DrawStreamEntry &entry) {
+            if (entry.Opaque != (pass == DrawPass::Opaque)) {
+                return;
+            }
+            const ClipRegion *clip = entry.Clip < 0 ? nullptr : &batch.mClips.Regions[entry.Clip];
+            const ClipState clipState = ResolveClipState(clip, constants.ViewProjection);
+            DrawPrimitives(entry, batch.mPrimitives[static_cast<size_t>(entry.Type)].BindingSetSpace0, clipState,
+                           draw.FirstOrdinal);
+        };
 
+        if (pass == DrawPass::Opaque) {
+            std::ranges::for_each(batch.mDrawStream | std::views::reverse, drawEntry);
+        } else {
+            std::ranges::for_each(batch.mDrawStream, drawEntry);
+        }
+    }
+
+    ClipState Renderer2D::ResolveClipState(const ClipRegion *clip, const glm::mat4 &viewProjection) {
+        ClipState state;
+        state.Scissor = nvrhi::Rect(0, static_cast<int>(mOutputSize.x), 0, static_cast<int>(mOutputSize.y));
+        if (clip == nullptr) {
+            return state;
+        }
+
+        // Triangles repeat their last point, which collapses the second half of the stencil fan
+        glm::mat4x2 points;
+        for (uint32_t i = 0; i < 4; ++i) {
+            const glm::vec2 point = clip->Points[std::min(i, clip->PointCount - 1)];
+            points[i] = glm::vec2(viewProjection * glm::vec4(point, 0.0f, 1.0f));
+        }
+
+        if (clip->PointCount == 4 && clip->ClipMode == ClipMode::ShowInside) {
+            // NVRHI uses D3D conventions on every backend, +y in clip space is the top row
+            glm::mat4x2 pixels;
+            for (int i = 0; i < 4; ++i) {
+                pixels[i] = glm::vec2(points[i].x * 0.5f + 0.5f, 0.5f - points[i].y * 0.5f) *
+                            glm::vec2(mOutputSize);
+            }
+
+            // A screen-aligned rectangle has alternating horizontal and vertical edges
+            constexpr float epsilon = 1e-3f;
+            bool evenHorizontal = true;
+            bool evenVertical = true;
+            for (int i = 0; i < 4; ++i) {
+                const glm::vec2 edge = pixels[(i + 1) % 4] - pixels[i];
+                const bool horizontal = std::abs(edge.y) <= epsilon;
+                const bool vertical = std::abs(edge.x) <= epsilon;
+                evenHorizontal = evenHorizontal && (i % 2 == 0 ? horizontal : vertical);
+                evenVertical = evenVertical && (i % 2 == 0 ? vertical : horizontal);
+            }
+
+            if (evenHorizontal || evenVertical) {
+                // Keeps the pixels whose center is inside, like a per-pixel test would
+                const glm::vec2 min = glm::min(glm::min(pixels[0], pixels[1]), glm::min(pixels[2], pixels[3]));
+                const glm::vec2 max = glm::max(glm::max(pixels[0], pixels[1]), glm::max(pixels[2], pixels[3]));
+                const glm::ivec2 first = glm::clamp(glm::ivec2(glm::ceil(min - 0.5f)), glm::ivec2(0),
+                                                    glm::ivec2(mOutputSize));
+                const glm::ivec2 last = glm::clamp(glm::ivec2(glm::ceil(max - 0.5f)), first,
+                                                   glm::ivec2(mOutputSize));
+                state.Scissor = nvrhi::Rect(first.x, last.x, first.y, last.y);
+                return state;
+            }
+        }
+
+        if (!mStencilClipPoints || *mStencilClipPoints != points) {
+            WriteClipStencil(points);
+        }
+
+        state.StencilTest = clip->ClipMode == ClipMode::ShowInside ? ClipStencilTest::Inside
+                                                                   : ClipStencilTest::Outside;
+        state.StencilReference = mStencilReference;
+        return state;
+    }
+
+    void Renderer2D::WriteClipStencil(const glm::mat4x2 &points) {
+        // Every written clip gets its own reference value, so nothing has to be erased until they run out
+        if (mStencilReference == ClipStencilParityBit - 1) {
+            mCommandList->clearDepthStencilTexture(mDepthStencilTexture, nvrhi::AllSubresources,
+                                                   false, 0.0f, true, 0);
+            mStencilReference = 0;
+        }
+        ++mStencilReference;
+        mStencilClipPoints = points;
+
+        nvrhi::GraphicsState state;
+        state.framebuffer = mFramebuffer;
+        state.viewport.addViewportAndScissorRect(mFramebuffer->getFramebufferInfo().getViewport());
+        state.dynamicStencilRefValue = mStencilReference;
+        state.bindings.push_back(mClipStencilBindingSet);
+
+        nvrhi::DrawArguments drawArgs;
+        drawArgs.vertexCount = 6;
+        for (nvrhi::IGraphicsPipeline *pipeline: {mClipStencilParityPipeline.Get(),
+                                                  mClipStencilResolvePipeline.Get()}) {
+            state.pipeline = pipeline;
+            mCommandList->setGraphicsState(state);
+            mCommandList->setPushConstants(&points, sizeof(glm::mat4x2));
             mCommandList->draw(drawArgs);
         }
-
-        mEllipseCommandList.GiveBackForNextFrame(std::move(submissions));
+
+        // The next primitive draw has to set its own state again
+        mBoundType.reset();
+        mBoundBindingSet = nullptr;
+        ++mStatistics.StencilClipWrites;
+    }
+
+    void Renderer2D::DrawStream() {
+        mBoundType.reset();
+        mBoundBindingSet = nullptr;
+        mBoundClip = {};
+
+        MergeDrawStream(mDrawStream, mMergedDrawStream);
+        auto drawEntry = [&](const DrawStreamEntry &entry) {
+            const ClipRegion *clip = entry.Clip < 0 ? nullptr : &mFrameClips.Regions[entry.Clip];
+            DrawPrimitives(entry, GetFrameBindingSet(entry.Type), ResolveClipState(clip, mViewProjectionMatrix), 0);
+        };
+
+        // Front to back, so the nearest opaque draws fill the depth buffer before the ones they hide are shaded
+        if (mStatistics.OpaquePrimitives > 0) {
+            for (const auto &entry: mMergedDrawStream | std::views::reverse) {
+                if (entry.Type != PrimitiveType::StaticBatch) {
+                    if (entry.Opaque) {
+                        drawEntry(entry);
+                    }
+                    continue;
+                }
+
+                for (uint32_t i = entry.First + entry.Count; i-- > entry.First;) {
+                    if (mStaticDraws[i].Batch->mOpaquePrimitiveCount > 0) {
+                        DrawStaticBatchInstance(mStaticDraws[i], DrawPass::Opaque);
+                    }
+                }
+            }
+        }
+
+        // Back to front, blending over everything drawn before them and hidden by the opaque draws after them
+        for (const auto &entry: mMergedDrawStream) {
+            if (entry.Type != PrimitiveType::StaticBatch) {
+                if (!entry.Opaque) {
+                    drawEntry(entry);
+                }
+                continue;
+            }
+
+            for (uint32_t i = entry.First; i < entry.First + entry.Count; ++i) {
+                const StaticBatch &batch = *mStaticDraws[i].Batch;
+                if (batch.mOpaquePrimitiveCount < batch.mPrimitiveCount) {
+                    DrawStaticBatchInstance(mStaticDraws[i], DrawPass::Translucent);
+                }
+            }
+        }
     }
 
     void Renderer2D::Submit() {
-        SubmitTriangleBatchRendering();
-        SubmitLineBatchRendering();
-        SubmitEllipseBatchRendering();
+        mDrawStream.clear();
+        mFrameClips.Clear();
+        mStatistics = {};
+        mStatistics.RetiredRenderTargets = static_cast<uint32_t>(mRetiredRenderTargets.size());
+        mStatistics.ResizeMilliseconds = mResizeMilliseconds;
+
+        MergeRecorders();
+
+        // Stamps the slots drawn this frame so that eviction keeps them
+        mVirtualTextureManager.MarkUsed(mTriangleCommandList.TextureIDs);
+        mVirtualTextureManager.MarkUsed(mEllipseCommandList.TextureIDs);
+        mVirtualTextureManager.MarkUsed(mSpriteCommandList.TextureIDs);
+
+        PrepareTriangleRendering();
+        PrepareLineRendering();
+        PrepareEllipseRendering();
+        PrepareSpriteRendering();
+        PrepareStaticBatchRendering();
+
+        UpdateFrameBindingSets();
+
+        mStatistics.UploadBufferGrowths =
+            mTriangleUpload.Primitives.GetGrowthCount() +
+            mLineUpload.Points.GetGrowthCount() + mLineUpload.Segments.GetGrowthCount() +
+            mEllipseUpload.Shapes.GetGrowthCount() +
+            mSpriteUpload.Primitives.GetGrowthCount();
+
+        const std::array<size_t, 5> uploadSizes = {
+            mTriangleUpload.Primitives.GetSize(),
+            mLineUpload.Points.GetSize(), mLineUpload.Segments.GetSize(),
+            mEllipseUpload.Shapes.GetSize(),
+            mSpriteUpload.Primitives.GetSize()
+        };
+        mSteadyUploadFrames = uploadSizes == mUploadSizes ? mSteadyUploadFrames + 1 : 0;
+        mUploadSizes = uploadSizes;
+
+#if defined(_DEBUG)
+        // Every slot already held these counts, and shrinking keeps twice the last use, so growing means the
+        // upload buffers reallocate in a warmed-up steady scene
+        if (mSteadyUploadFrames >= mFramesInFlight && mStatistics.UploadBufferGrowths != 0) {
+            throw Engine::RuntimeException("Renderer2D: Upload buffers grew in a steady scene.");
+        }
+#endif
+
+        // Textures are sampled through the bindless table, which does not transition them on its own
+        mVirtualTextureManager.RequireShaderResourceStates(mCommandList);
+
+        SortDrawStream(mDrawStream);
+        AssignDrawOrdinals();
+
+        const float visibleArea = (mVisibleBounds.z - mVisibleBounds.x) * (mVisibleBounds.w - mVisibleBounds.y);
+        mStatistics.OpaqueOverdraw /= visibleArea;
+        mStatistics.TranslucentOverdraw /= visibleArea;
+
+        DrawStream();
     }
 
     void Renderer2D::RecalculateViewProjectionMatrix() {
@@ -649,6 +1396,9 @@ Engine {
         float halfVisibleWidth = static_cast<float>(mOutputSize.x) / (2.0f * uniformScale);
         float halfVisibleHeight = static_cast<float>(mOutputSize.y) / (2.0f * uniformScale);
 
+        mVisibleBounds = glm::vec4(-halfVisibleWidth, -halfVisibleHeight, halfVisibleWidth, halfVisibleHeight);
+        mPixelSize = 1.0f / uniformScale;
+
         mViewProjectionMatrix = glm::ortho(
             -halfVisibleWidth, // Left
             halfVisibleWidth, // Right
@@ -664,47 +1414,135 @@ Engine {
     }
 
     void Renderer2D::Clear() {
-        mTriangleCommandList.Clear();
-        mLineCommandList.Clear();
-        mEllipseCommandList.Clear();
+        Renderer2DRecorder::Clear();
+        mStaticDraws.clear();
+        for (auto &recorder: mRecorders) {
+            recorder->Clear();
+        }
+    }
+
+    Renderer2DRecorder &Renderer2D::GetRecorder(uint32_t index) {
+        std::lock_guard lock(mRecordersMutex);
+        while (mRecorders.size() <= index) {
+            mRecorders.push_back(std::make_unique<Renderer2DRecorder>(&mVirtualTextureManager, &mVirtualTextureMutex));
+        }
+        return *mRecorders[index];
+    }
+
+    void Renderer2D::DrawStaticBatch(StaticBatch &batch, const glm::mat3 &transform,
+                                     std::optional<int> overrideDepth) {
+        // 2D affine transform embedded into the xy plane
+        glm::mat4 model(1.0f);
+        model[0] = glm::vec4(transform[0].x, transform[0].y, 0.0f, 0.0f);
+        model[1] = glm::vec4(transform[1].x, transform[1].y, 0.0f, 0.0f);
+        model[3] = glm::vec4(transform[2].x, transform[2].y, 0.0f, 1.0f);
+
+        mStaticDraws.push_back({&batch, model, overrideDepth.value_or(mCurrentDepth)});
+    }
+
+    void Renderer2D::MergeRecorders() {
+        for (const auto &recorder: mRecorders) {
+            Append(*recorder);
+        }
+    }
+
+    int Renderer2DRecorder::GetCurrentDepth() const {
+        return mCurrentDepth;
+    }
+
+    void Renderer2DRecorder::SetCurrentDepth(int depth) {
+        mCurrentDepth = depth;
+    }
+
+    const glm::vec4 &Renderer2D::GetVisibleBounds() const {
+        return mVisibleBounds;
+    }
+
+    const Renderer2DStatistics &Renderer2D::GetStatistics() const {
+        return mStatistics;
+    }
+
+    void Renderer2DRecorder::PushClip(const ClipRegion &clip) {
+        mClipStack.push_back(clip);
+    }
+
+    void Renderer2DRecorder::PopClip() {
+        if (mClipStack.empty()) {
+            throw Engine::RuntimeException("Renderer2D: PopClip called without a matching PushClip.");
+        }
+        mClipStack.pop_back();
+    }
+
+    const ClipRegion *Renderer2DRecorder::GetCurrentClip() const {
+        return mClipStack.empty() ? nullptr : &mClipStack.back();
+    }
+
+    const ClipRegion *Renderer2DRecorder::ActiveClip(const ClipRegion *clip) const {
+        return clip != nullptr ? clip : GetCurrentClip();
+    }
+
+    uint32_t Renderer2DRecorder::RegisterVirtualTextureForThisFrame(const nvrhi::TextureHandle &texture,
+                                                                    bool opaque) {
+        return RegisterVirtualTexture(texture, opaque).Slot;
     }
 
-    uint32_t Renderer2D::RegisterVirtualTextureForThisFrame(const nvrhi::TextureHandle &texture) {
-        return mVirtualTextureManager.RegisterTexture(texture);
+    VirtualTextureHandle Renderer2DRecorder::RegisterVirtualTexture(const nvrhi::TextureHandle &texture,
+                                                                    bool opaque) {
+        std::lock_guard lock(*mSharedVirtualTextureMutex);
+        if (mGrowTexturesOnDemand &&
+            mSharedVirtualTextureManager->GetCurrentSize() == mSharedVirtualTextureManager->GetCapacity()) {
+            mSharedVirtualTextureManager->Optimize();
+        }
+        return mSharedVirtualTextureManager->RegisterTexture(texture, opaque);
+    }
+
+    bool Renderer2DRecorder::IsOpaqueDraw(const glm::u8vec4 &tintColor, int virtualTextureID) const {
+        return tintColor.a == 255 &&
+               (virtualTextureID < 0 ||
+                mSharedVirtualTextureManager->IsOpaque(static_cast<uint32_t>(virtualTextureID)));
+    }
+
+    std::optional<uint32_t> Renderer2DRecorder::ResolveVirtualTexture(VirtualTextureHandle handle) const {
+        if (!mSharedVirtualTextureManager->IsValid(handle)) {
+            return std::nullopt;
+        }
+        return handle.Slot;
     }
 
-    void Renderer2D::DrawTriangleColored(const glm::mat3x2 &positions,
-                                         const glm::u8vec4 &color,
-                                         std::optional<int> overrideDepth,
-                                         const ClipRegion *clip) {
+    void Renderer2DRecorder::DrawTriangleColored(const glm::mat3x2 &positions,
+                                                 const glm::u8vec4 &color,
+                                                 std::optional<int> overrideDepth,
+                                                 const ClipRegion *clip) {
         mTriangleCommandList.AddTriangle(
             positions[0], glm::vec2(0.f, 0.f),
             positions[1], glm::vec2(0.f, 0.f),
             positions[2], glm::vec2(0.f, 0.f),
             -1,
             (color.r << 24) | (color.g << 16) | (color.b << 8) | color.a,
-            overrideDepth.has_value() ? overrideDepth.value() : mCurrentDepth, clip);
+            overrideDepth.has_value() ? overrideDepth.value() : mCurrentDepth, ActiveClip(clip),
+            IsOpaqueDraw(color, -1));
     }
 
-    void Renderer2D::DrawTriangleTextureVirtual(const glm::mat3x2 &positions,
-                                                const glm::mat3x2 &uvs,
-                                                uint32_t virtualTextureID,
-                                                std::optional<int> overrideDepth,
-                                                glm::u8vec4 tintColor, const ClipRegion *clip) {
+    void Renderer2DRecorder::DrawTriangleTextureVirtual(const glm::mat3x2 &positions,
+                                                        const glm::mat3x2 &uvs,
+                                                        uint32_t virtualTextureID,
+                                                        std::optional<int> overrideDepth,
+                                                        glm::u8vec4 tintColor, const ClipRegion *clip) {
         mTriangleCommandList.AddTriangle(
             positions[0], uvs[0],
             positions[1], uvs[1],
             positions[2], uvs[2],
             static_cast<int>(virtualTextureID),
             (tintColor.r << 24) | (tintColor.g << 16) | (tintColor.b << 8) | tintColor.a,
-            overrideDepth.has_value() ? overrideDepth.value() : mCurrentDepth, clip);
+            overrideDepth.has_value() ? overrideDepth.value() : mCurrentDepth, ActiveClip(clip),
+            IsOpaqueDraw(tintColor, static_cast<int>(virtualTextureID)));
     }
 
-    uint32_t Renderer2D::DrawTriangleTextureManaged(const glm::mat3x2 &positions,
-                                                    const glm::mat3x2 &uvs,
-                                                    const nvrhi::TextureHandle &texture,
-                                                    std::optional<int> overrideDepth,
-                                                    glm::u8vec4 tintColor, const ClipRegion *clip) {
+    uint32_t Renderer2DRecorder::DrawTriangleTextureManaged(const glm::mat3x2 &positions,
+                                                            const glm::mat3x2 &uvs,
+                                                            const nvrhi::TextureHandle &texture,
+                                                            std::optional<int> overrideDepth,
+                                                            glm::u8vec4 tintColor, const ClipRegion *clip) {
         uint32_t virtualTextureID = RegisterVirtualTextureForThisFrame(texture);
         mTriangleCommandList.AddTriangle(
             positions[0], uvs[0],
@@ -712,13 +1550,14 @@ Engine {
             positions[2], uvs[2],
             static_cast<int>(virtualTextureID),
             (tintColor.r << 24) | (tintColor.g << 16) | (tintColor.b << 8) | tintColor.a,
-            overrideDepth.has_value() ? overrideDepth.value() : mCurrentDepth, clip);
+            overrideDepth.has_value() ? overrideDepth.value() : mCurrentDepth, ActiveClip(clip),
+            IsOpaqueDraw(tintColor, static_cast<int>(virtualTextureID)));
         return virtualTextureID;
     }
 
-    void Renderer2D::DrawQuadColored(const glm::mat4x2 &positions,
-                                     const glm::u8vec4 &color,
-                                     std::optional<int> overrideDepth, const ClipRegion *clip) {
+    void Renderer2DRecorder::DrawQuadColored(const glm::mat4x2 &positions,
+                                             const glm::u8vec4 &color,
+                                             std::optional<int> overrideDepth, const ClipRegion *clip) {
         mTriangleCommandList.AddQuad(
             positions[0], glm::vec2(0.f, 0.f),
             positions[1], glm::vec2(0.f, 0.f),
@@ -726,14 +1565,15 @@ Engine {
             positions[3], glm::vec2(0.f, 0.f),
             -1,
             (color.r << 24) | (color.g << 16) | (color.b << 8) | color.a,
-            overrideDepth.has_value() ? overrideDepth.value() : mCurrentDepth, clip);
+            overrideDepth.has_value() ? overrideDepth.value() : mCurrentDepth, ActiveClip(clip),
+            IsOpaqueDraw(color, -1));
     }
 
-    void Renderer2D::DrawQuadTextureVirtual(const glm::mat4x2 &positions,
-                                            const glm::mat4x2 &uvs,
-                                            uint32_t virtualTextureID,
-                                            std::optional<int> overrideDepth,
-                                            glm::u8vec4 tintColor, const ClipRegion *clip) {
+    void Renderer2DRecorder::DrawQuadTextureVirtual(const glm::mat4x2 &positions,
+                                                    const glm::mat4x2 &uvs,
+                                                    uint32_t virtualTextureID,
+                                                    std::optional<int> overrideDepth,
+                                                    glm::u8vec4 tintColor, const ClipRegion *clip) {
         mTriangleCommandList.AddQuad(
             positions[0], uvs[0],
             positions[1], uvs[1],
@@ -741,14 +1581,15 @@ Engine {
             positions[3], uvs[3],
             static_cast<int>(virtualTextureID),
             (tintColor.r << 24) | (tintColor.g << 16) | (tintColor.b << 8) | tintColor.a,
-            overrideDepth.has_value() ? overrideDepth.value() : mCurrentDepth, clip);
+            overrideDepth.has_value() ? overrideDepth.value() : mCurrentDepth, ActiveClip(clip),
+            IsOpaqueDraw(tintColor, static_cast<int>(virtualTextureID)));
     }
 
-    uint32_t Renderer2D::DrawQuadTextureManaged(const glm::mat4x2 &positions,
-                                                const glm::mat4x2 &uvs,
-                                                const nvrhi::TextureHandle &texture,
-                                                std::optional<int> overrideDepth,
-                                                glm::u8vec4 tintColor, const ClipRegion *clip) {
+    uint32_t Renderer2DRecorder::DrawQuadTextureManaged(const glm::mat4x2 &positions,
+                                                        const glm::mat4x2 &uvs,
+                                                        const nvrhi::TextureHandle &texture,
+                                                        std::optional<int> overrideDepth,
+                                                        glm::u8vec4 tintColor, const ClipRegion *clip) {
         uint32_t virtualTextureID = RegisterVirtualTextureForThisFrame(texture);
         mTriangleCommandList.AddQuad(
             positions[0], uvs[0],
@@ -757,144 +1598,190 @@ Engine {
             positions[3], uvs[3],
             static_cast<int>(virtualTextureID),
             (tintColor.r << 24) | (tintColor.g << 16) | (tintColor.b << 8) | tintColor.a,
-            overrideDepth.has_value() ? overrideDepth.value() : mCurrentDepth, clip);
+            overrideDepth.has_value() ? overrideDepth.value() : mCurrentDepth, ActiveClip(clip),
+            IsOpaqueDraw(tintColor, static_cast<int>(virtualTextureID)));
+        return virtualTextureID;
+    }
+
+    void Renderer2DRecorder::DrawSpriteColored(const glm::vec2 &center, const glm::vec2 &size, float rotation,
+                                               const glm::u8vec4 &color,
+                                               std::optional<int> overrideDepth, const ClipRegion *clip) {
+        mSpriteCommandList.AddSprite(
+            center, size * 0.5f, rotation, glm::vec4(0.0f), -1,
+            (color.r << 24) | (color.g << 16) | (color.b << 8) | color.a,
+            overrideDepth.value_or(mCurrentDepth), ActiveClip(clip), IsOpaqueDraw(color, -1));
+    }
+
+    void Renderer2DRecorder::DrawSpriteTextureVirtual(const glm::vec2 &center, const glm::vec2 &size, float rotation,
+                                                      uint32_t virtualTextureID, const glm::vec4 &uvRect,
+                                                      std::optional<int> overrideDepth,
+                                                      glm::u8vec4 tintColor, const ClipRegion *clip) {
+        mSpriteCommandList.AddSprite(
+            center, size * 0.5f, rotation, uvRect, static_cast<int>(virtualTextureID),
+            (tintColor.r << 24) | (tintColor.g << 16) | (tintColor.b << 8) | tintColor.a,
+            overrideDepth.value_or(mCurrentDepth), ActiveClip(clip),
+            IsOpaqueDraw(tintColor, static_cast<int>(virtualTextureID)));
+    }
+
+    uint32_t Renderer2DRecorder::DrawSpriteTextureManaged(const glm::vec2 &center, const glm::vec2 &size, float rotation,
+                                                          const nvrhi::TextureHandle &texture, const glm::vec4 &uvRect,
+                                                          std::optional<int> overrideDepth,
+                                                          glm::u8vec4 tintColor, const ClipRegion *clip) {
+        uint32_t virtualTextureID = RegisterVirtualTextureForThisFrame(texture);
+        DrawSpriteTextureVirtual(center, size, rotation, virtualTextureID, uvRect, overrideDepth, tintColor, clip);
         return virtualTextureID;
     }
 
-    void Renderer2D::DrawLine(const glm::vec2 &p0, const glm::vec2 &p1,
-                              const glm::u8vec4 &color) {
-        mLineCommandList.AddLine(p0, color, p1, color);
+    void Renderer2DRecorder::DrawLine(const glm::vec2 &p0, const glm::vec2 &p1,
+                                      const glm::u8vec4 &color, std::optional<int> overrideDepth) {
+        mLineCommandList.AddLine(p0, color, p1, color, LineStyle{}, overrideDepth.value_or(mCurrentDepth),
+                                 ActiveClip(nullptr));
+    }
+
+    void Renderer2DRecorder::DrawLine(const glm::vec2 &p0, const glm::vec2 &p1,
+                                      const glm::u8vec4 &color0, const glm::u8vec4 &color1,
+                                      std::optional<int> overrideDepth) {
+        mLineCommandList.AddLine(p0, color0, p1, color1, LineStyle{}, overrideDepth.value_or(mCurrentDepth),
+                                 ActiveClip(nullptr));
+    }
+
+    void Renderer2DRecorder::DrawLine(const glm::vec2 &p0, const glm::vec2 &p1, const glm::u8vec4 &color,
+                                      const LineStyle &style, std::optional<int> overrideDepth,
+                                      const ClipRegion *clip) {
+        mLineCommandList.AddLine(p0, color, p1, color, style, overrideDepth.value_or(mCurrentDepth),
+                                 ActiveClip(clip));
     }
 
-    void Renderer2D::DrawLine(const glm::vec2 &p0, const glm::vec2 &p1,
-                              const glm::u8vec4 &color0, const glm::u8vec4 &color1) {
-        mLineCommandList.AddLine(p0, color0, p1, color1);
+    void Renderer2DRecorder::DrawPolyline(std::span<const glm::vec2> points, const glm::u8vec4 &color,
+                                          const LineStyle &style, std::optional<int> overrideDepth,
+                                          const ClipRegion *clip) {
+        mLineCommandList.AddPolyline(points, color, style, overrideDepth.value_or(mCurrentDepth), ActiveClip(clip));
     }
 
-    void Renderer2D::DrawCircle(const glm::vec2 &center, float radius,
-                                const glm::u8vec4 &color,
-                                std::optional<int> overrideDepth, const ClipRegion *clip) {
+    void Renderer2DRecorder::DrawCircle(const glm::vec2 &center, float radius,
+                                        const glm::u8vec4 &color,
+                                        std::optional<int> overrideDepth, const ClipRegion *clip) {
         EllipseRenderingData data = EllipseRenderingData::Circle(
-            center, radius, color, overrideDepth.value_or(mCurrentDepth), clip);
+            center, radius, color, overrideDepth.value_or(mCurrentDepth), ActiveClip(clip));
         mEllipseCommandList.AddEllipse(data);
     }
 
-    void Renderer2D::DrawEllipse(const glm::vec2 &center, const glm::vec2 &radii,
-                                 float rotation, const glm::u8vec4 &color,
-                                 std::optional<int> overrideDepth, const ClipRegion *clip) {
+    void Renderer2DRecorder::DrawEllipse(const glm::vec2 &center, const glm::vec2 &radii,
+                                         float rotation, const glm::u8vec4 &color,
+                                         std::optional<int> overrideDepth, const ClipRegion *clip) {
         EllipseRenderingData data = EllipseRenderingData::Ellipse(
-            center, radii, rotation, color, overrideDepth.value_or(mCurrentDepth), clip);
+            center, radii, rotation, color, overrideDepth.value_or(mCurrentDepth), ActiveClip(clip));
         mEllipseCommandList.AddEllipse(data);
     }
 
-    void Renderer2D::DrawRing(const glm::vec2 &center, float outerRadius, float innerRadius,
-                              const glm::u8vec4 &color,
-                              std::optional<int> overrideDepth, const ClipRegion *clip) {
+    void Renderer2DRecorder::DrawRing(const glm::vec2 &center, float outerRadius, float innerRadius,
+                                      const glm::u8vec4 &color,
+                                      std::optional<int> overrideDepth, const ClipRegion *clip) {
         EllipseRenderingData data = EllipseRenderingData::Ring(
-            center, outerRadius, innerRadius, color, overrideDepth.value_or(mCurrentDepth), clip);
+            center, outerRadius, innerRadius, color, overrideDepth.value_or(mCurrentDepth), ActiveClip(clip));
         mEllipseCommandList.AddEllipse(data);
     }
 
-    void Renderer2D::DrawSector(const glm::vec2 &center, float radius,
-                                float startAngle, float endAngle,
-                                const glm::u8vec4 &color,
-                                std::optional<int> overrideDepth, const ClipRegion *clip) {
+    void Renderer2DRecorder::DrawSector(const glm::vec2 &center, float radius,
+                                        float startAngle, float endAngle,
+                                        const glm::u8vec4 &color,
+                                        std::optional<int> overrideDepth, const ClipRegion *clip) {
         EllipseRenderingData data = EllipseRenderingData::Sector(
-            center, radius, startAngle, endAngle, color, -1, overrideDepth.value_or(mCurrentDepth), clip);
+            center, radius, startAngle, endAngle, color, -1, overrideDepth.value_or(mCurrentDepth), ActiveClip(clip));
         mEllipseCommandList.AddEllipse(data);
     }
 
-    void Renderer2D::DrawSectorTextureVirtual(const glm::vec2 &center, float radius,
-                                              float startAngle, float endAngle,
-                                              uint32_t virtualTextureID,
-                                              const glm::u8vec4 &tintColor,
-                                              std::optional<int> overrideDepth, const ClipRegion *clip) {
+    void Renderer2DRecorder::DrawSectorTextureVirtual(const glm::vec2 &center, float radius,
+                                                      float startAngle, float endAngle,
+                                                      uint32_t virtualTextureID,
+                                                      const glm::u8vec4 &tintColor,
+                                                      std::optional<int> overrideDepth, const ClipRegion *clip) {
         EllipseRenderingData data = EllipseRenderingData::Sector(
             center, radius, startAngle, endAngle, tintColor,
-            static_cast<int>(virtualTextureID), overrideDepth.value_or(mCurrentDepth), clip);
+            static_cast<int>(virtualTextureID), overrideDepth.value_or(mCurrentDepth), ActiveClip(clip));
         mEllipseCommandList.AddEllipse(data);
     }
 
-    uint32_t Renderer2D::DrawSectorTextureManaged(const glm::vec2 &center, float radius,
-                                                  float startAngle, float endAngle,
-                                                  const nvrhi::TextureHandle &texture,
-                                                  const glm::u8vec4 &tintColor,
-                                                  std::optional<int> overrideDepth, const ClipRegion *clip) {
+    uint32_t Renderer2DRecorder::DrawSectorTextureManaged(const glm::vec2 &center, float radius,
+                                                          float startAngle, float endAngle,
+                                                          const nvrhi::TextureHandle &texture,
+                                                          const glm::u8vec4 &tintColor,
+                                                          std::optional<int> overrideDepth, const ClipRegion *clip) {
         uint32_t virtualTextureID = RegisterVirtualTextureForThisFrame(texture);
         EllipseRenderingData data = EllipseRenderingData::Sector(
             center, radius, startAngle, endAngle, tintColor,
-            static_cast<int>(virtualTextureID), overrideDepth.value_or(mCurrentDepth), clip);
+            static_cast<int>(virtualTextureID), overrideDepth.value_or(mCurrentDepth), ActiveClip(clip));
         mEllipseCommandList.AddEllipse(data);
         return virtualTextureID;
     }
 
-    void Renderer2D::DrawArc(const glm::vec2 &center, float radius, float thickness,
-                             float startAngle, float endAngle,
-                             const glm::u8vec4 &color,
-                             std::optional<int> overrideDepth, const ClipRegion *clip) {
+    void Renderer2DRecorder::DrawArc(const glm::vec2 &center, float radius, float thickness,
+                                     float startAngle, float endAngle,
+                                     const glm::u8vec4 &color,
+                                     std::optional<int> overrideDepth, const ClipRegion *clip) {
         EllipseRenderingData data = EllipseRenderingData::Arc(
-            center, radius, thickness, startAngle, endAngle, color, overrideDepth.value_or(mCurrentDepth), clip);
+            center, radius, thickness, startAngle, endAngle, color, overrideDepth.value_or(mCurrentDepth), ActiveClip(clip));
         mEllipseCommandList.AddEllipse(data);
     }
 
-    void Renderer2D::DrawEllipseSector(const glm::vec2 &center, const glm::vec2 &radii,
-                                       float rotation, float startAngle, float endAngle,
-                                       const glm::u8vec4 &color,
-                                       std::optional<int> overrideDepth, const ClipRegion *clip) {
+    void Renderer2DRecorder::DrawEllipseSector(const glm::vec2 &center, const glm::vec2 &radii,
+                                               float rotation, float startAngle, float endAngle,
+                                               const glm::u8vec4 &color,
+                                               std::optional<int> overrideDepth, const ClipRegion *clip) {
         EllipseRenderingData data = EllipseRenderingData::EllipseSector(
-            center, radii, rotation, startAngle, endAngle, color, -1, overrideDepth.value_or(mCurrentDepth), clip);
+            center, radii, rotation, startAngle, endAngle, color, -1, overrideDepth.value_or(mCurrentDepth), ActiveClip(clip));
         mEllipseCommandList.AddEllipse(data);
     }
 
-    void Renderer2D::DrawEllipseSectorTextureVirtual(const glm::vec2 &center, const glm::vec2 &radii,
-                                                     float rotation, float startAngle, float endAngle,
-                                                     uint32_t virtualTextureID,
-                                                     const glm::u8vec4 &tintColor,
-                                                     std::optional<int> overrideDepth, const ClipRegion *clip) {
+    void Renderer2DRecorder::DrawEllipseSectorTextureVirtual(const glm::vec2 &center, const glm::vec2 &radii,
+                                                             float rotation, float startAngle, float endAngle,
+                                                             uint32_t virtualTextureID,
+                                                             const glm::u8vec4 &tintColor,
+                                                             std::optional<int> overrideDepth, const ClipRegion *clip) {
         EllipseRenderingData data = EllipseRenderingData::EllipseSector(
             center, radii, rotation, startAngle, endAngle, tintColor,
-            static_cast<int>(virtualTextureID), overrideDepth.value_or(mCurrentDepth), clip);
+            static_cast<int>(virtualTextureID), overrideDepth.value_or(mCurrentDepth), ActiveClip(clip));
         mEllipseCommandList.AddEllipse(data);
     }
 
-    void Renderer2D::DrawEllipseArc(const glm::vec2 &center, const glm::vec2 &radii,
-                                    float rotation, float thickness,
-                                    float startAngle, float endAngle,
-                                    const glm::u8vec4 &color,
-                                    std::optional<int> overrideDepth, const ClipRegion *clip) {
+    void Renderer2DRecorder::DrawEllipseArc(const glm::vec2 &center, const glm::vec2 &radii,
+                                            float rotation, float thickness,
+                                            float startAngle, float endAngle,
+                                            const glm::u8vec4 &color,
+                                            std::optional<int> overrideDepth, const ClipRegion *clip) {
         EllipseRenderingData data = EllipseRenderingData::EllipseArc(
             center, radii, rotation, thickness, startAngle, endAngle, color, overrideDepth.value_or(mCurrentDepth),
-            clip);
+            ActiveClip(clip));
         mEllipseCommandList.AddEllipse(data);
     }
 
-    void Renderer2D::DrawCircleTextureVirtual(const glm::vec2 &center, float radius,
-                                              uint32_t virtualTextureID,
-                                              const glm::u8vec4 &tintColor,
-                                              std::optional<int> overrideDepth, const ClipRegion *clip) {
+    void Renderer2DRecorder::DrawCircleTextureVirtual(const glm::vec2 &center, float radius,
+                                                      uint32_t virtualTextureID,
+                                                      const glm::u8vec4 &tintColor,
+                                                      std::optional<int> overrideDepth, const ClipRegion *clip) {
         EllipseRenderingData data;
         data.Center = center;
         data.Radii = glm::vec2(radius, radius);
         data.VirtualTextureID = static_cast<int>(virtualTextureID);
         data.TintColor = (tintColor.r << 24) | (tintColor.g << 16) | (tintColor.b << 8) | tintColor.a;
         data.Depth = overrideDepth.value_or(mCurrentDepth);
-        data.Clip = clip ? std::optional{*clip} : std::nullopt;
+        data.Clip = ActiveClip(clip);
         mEllipseCommandList.AddEllipse(data);
     }
 
-    uint32_t Renderer2D::DrawCircleTextureManaged(const glm::vec2 &center, float radius,
-                                                  const nvrhi::TextureHandle &texture,
-                                                  const glm::u8vec4 &tintColor,
-                                                  std::optional<int> overrideDepth, const ClipRegion *clip) {
+    uint32_t Renderer2DRecorder::DrawCircleTextureManaged(const glm::vec2 &center, float radius,
+                                                          const nvrhi::TextureHandle &texture,
+                                                          const glm::u8vec4 &tintColor,
+                                                          std::optional<int> overrideDepth, const ClipRegion *clip) {
         uint32_t virtualTextureID = RegisterVirtualTextureForThisFrame(texture);
         DrawCircleTextureVirtual(center, radius, virtualTextureID, tintColor, overrideDepth, clip);
         return virtualTextureID;
     }
 
-    void Renderer2D::DrawEllipseTextureVirtual(const glm::vec2 &center, const glm::vec2 &radii,
-                                               float rotation, uint32_t virtualTextureID,
-                                               const glm::u8vec4 &tintColor,
-                                               std::optional<int> overrideDepth, const ClipRegion *clip) {
+    void Renderer2DRecorder::DrawEllipseTextureVirtual(const glm::vec2 &center, const glm::vec2 &radii,
+                                                       float rotation, uint32_t virtualTextureID,
+                                                       const glm::u8vec4 &tintColor,
+                                                       std::optional<int> overrideDepth, const ClipRegion *clip) {
         EllipseRenderingData data;
         data.Center = center;
         data.Radii = radii;
@@ -902,15 +1789,15 @@ Engine {
         data.VirtualTextureID = static_cast<int>(virtualTextureID);
         data.TintColor = (tintColor.r << 24) | (tintColor.g << 16) | (tintColor.b << 8) | tintColor.a;
         data.Depth = overrideDepth.value_or(mCurrentDepth);
-        data.Clip = clip ? std::optional{*clip} : std::nullopt;
+        data.Clip = ActiveClip(clip);
         mEllipseCommandList.AddEllipse(data);
     }
 
-    uint32_t Renderer2D::DrawEllipseTextureManaged(const glm::vec2 &center, const glm::vec2 &radii,
-                                                   float rotation,
-                                                   const nvrhi::TextureHandle &texture,
-                                                   const glm::u8vec4 &tintColor,
-                                                   std::optional<int> overrideDepth, const ClipRegion *clip) {
+    uint32_t Renderer2DRecorder::DrawEllipseTextureManaged(const glm::vec2 &center, const glm::vec2 &radii,
+                                                           float rotation,
+                                                           const nvrhi::TextureHandle &texture,
+                                                           const glm::u8vec4 &tintColor,
+                                                           std::optional<int> overrideDepth, const ClipRegion *clip) {
         uint32_t virtualTextureID = RegisterVirtualTextureForThisFrame(texture);
         DrawEllipseTextureVirtual(center, radii, rotation, virtualTextureID, tintColor, overrideDepth, clip);
         return virtualTextureID;
@@ -921,6 +1808,16 @@ Engine {
 
 namespace
 Engine {
+    // Depth in the high half (sign flipped so negative depths order first), TranslucentSortKeyBit unless opaque
+    // and texture slot + 1 in the low 15 bits. Bits 16..31 receive the clip when the list is recorded, so the
+    // opaque draws of a depth and clip come first. Textures never split a draw, their bits only keep draws of one
+    // texture together. Ties are broken by the stable radix sort, which keeps submission order.
+    uint64_t MakeDrawSortKey(int depth, int virtualTextureID, bool opaque = false) {
+        uint64_t depthBits = static_cast<uint32_t>(depth) ^ 0x80000000u;
+        uint64_t textureBits = static_cast<uint32_t>(virtualTextureID + 1) & 0x7FFF;
+        return (depthBits << 32) | (opaque ? 0 : TranslucentSortKeyBit) | textureBits;
+    }
+
     ClipRegion ClipRegion::Triangle(const glm::mat3x2 &points, Frosty::ClipMode clipMode) {
         return ClipRegion{
             .Points = {
@@ -947,269 +1844,648 @@ Engine {
         };
     }
 
-    TriangleRenderingData TriangleRenderingData::Triangle(const glm::vec2 &p0, const glm::vec2 &uv0,
-                                                          const glm::vec2 &p1, const glm::vec2 &uv1,
-                                                          const glm::vec2 &p2, const glm::vec2 &uv2,
-                                                          int textureIndex,
-                                                          uint32_t tintColor, int depth,
-                                                          const ClipRegion *clip) {
-        TriangleRenderingData data;
-        data.Positions[0] = p0;
-        data.Positions[1] = p1;
-        data.Positions[2] = p2;
-        data.TexCoords[0] = uv0;
-        data.TexCoords[1] = uv1;
-        data.TexCoords[2] = uv2;
-        data.IsQuad = false;
-        data.VirtualTextureID = textureIndex;
-        data.TintColor = tintColor;
-        data.Depth = depth;
-        if (clip != nullptr) {
-            data.Clip = *clip;
+    size_t ClipRegionHash::operator()(const ClipRegion &clip) const {
+        // FNV-1a over the raw bytes, ClipRegion has no padding
+        const auto *bytes = reinterpret_cast<const uint8_t *>(&clip);
+        uint64_t hash = 0xcbf29ce484222325ull;
+        for (size_t i = 0; i < sizeof(ClipRegion); ++i) {
+            hash = (hash ^ bytes[i]) * 0x100000001b3ull;
         }
-        return data;
+        return static_cast<size_t>(hash);
     }
 
-    TriangleRenderingData TriangleRenderingData::Quad(const glm::vec2 &p0, const glm::vec2 &uv0,
-                                                      const glm::vec2 &p1, const glm::vec2 &uv1,
-                                                      const glm::vec2 &p2, const glm::vec2 &uv2,
-                                                      const glm::vec2 &p3, const glm::vec2 &uv3,
-                                                      int virtualTextureID,
-                                                      uint32_t tintColor, int depth,
-                                                      const ClipRegion *clip) {
-        TriangleRenderingData data;
-        data.Positions[0] = p0;
-        data.Positions[1] = p1;
-        data.Positions[2] = p2;
-        data.Positions[3] = p3;
-        data.TexCoords[0] = uv0;
-        data.TexCoords[1] = uv1;
-        data.TexCoords[2] = uv2;
-        data.TexCoords[3] = uv3;
-        data.IsQuad = true;
-        data.VirtualTextureID = virtualTextureID;
-        data.TintColor = tintColor;
-        data.Depth = depth;
-        if (clip != nullptr) {
-            data.Clip = *clip;
-        }
-        return data;
+    bool ClipRegionEqual::operator()(const ClipRegion &lhs, const ClipRegion &rhs) const {
+        return std::memcmp(&lhs, &rhs, sizeof(ClipRegion)) == 0;
     }
 
-    void TriangleRenderingSubmissionData::Clear() {
-        VertexData.clear();
-        IndexData.clear();
-        InstanceData.clear();
-        ClipData.clear();
-    }
+    int32_t ClipRegionTable::Intern(const ClipRegion &clip) {
+        // Consecutive draws usually share the clip of the panel they belong to
+        if (mLastHandle >= 0 && ClipRegionEqual{}(Regions[mLastHandle], clip)) {
+            return mLastHandle;
+        }
 
-    void TriangleRenderingCommandList::AddTriangle(const glm::vec2 &p0, const glm::vec2 &uv0,
-                                                   const glm::vec2 &p1, const glm::vec2 &uv1,
-                                                   const glm::vec2 &p2, const glm::vec2 &uv2,
-                                                   int virtualTextureID,
-                                                   uint32_t tintColor,
-                                                   int depth, const ClipRegion *clip) {
-        Instances.resize(Instances.size() + 1);
-        Instances.back() = TriangleRenderingData::Triangle(
-            p0, uv0, p1, uv1, p2, uv2, virtualTextureID, tintColor, depth, clip);
+        // Keep the load factor at or below one half
+        if ((Regions.size() + 1) * 2 > mSlots.size()) {
+            Rehash(std::max<size_t>(64, mSlots.size() * 2));
+        }
+
+        const size_t mask = mSlots.size() - 1;
+        for (size_t slot = ClipRegionHash{}(clip) & mask;; slot = (slot + 1) & mask) {
+            int32_t handle = mSlots[slot];
+            if (handle < 0) {
+                handle = static_cast<int32_t>(Regions.size());
+                Regions.push_back(clip);
+                mSlots[slot] = handle;
+                mLastHandle = handle;
+                return handle;
+            }
+            if (ClipRegionEqual{}(Regions[handle], clip)) {
+                mLastHandle = handle;
+                return handle;
+            }
+        }
     }
 
-    void TriangleRenderingCommandList::AddQuad(const glm::vec2 &p0, const glm::vec2 &uv0,
-                                               const glm::vec2 &p1, const glm::vec2 &uv1,
-                                               const glm::vec2 &p2, const glm::vec2 &uv2,
-                                               const glm::vec2 &p3, const glm::vec2 &uv3,
-                                               int virtualTextureID,
-                                               uint32_t tintColor,
-                                               int depth, const ClipRegion *clip) {
-        Instances.resize(Instances.size() + 1);
-        Instances.back() = TriangleRenderingData::Quad(
-            p0, uv0, p1, uv1, p2, uv2, p3, uv3, virtualTextureID, tintColor, depth, clip);
+    void ClipRegionTable::Clear() {
+        Regions.clear();
+        std::ranges::fill(mSlots, -1);
+        mLastHandle = -1;
     }
 
-    void TriangleRenderingCommandList::Clear() {
-        Instances.clear();
+    void ClipRegionTable::Rehash(size_t slotCount) {
+        mSlots.assign(slotCount, -1);
+        const size_t mask = slotCount - 1;
+        for (size_t handle = 0; handle < Regions.size(); ++handle) {
+            size_t slot = ClipRegionHash{}(Regions[handle]) & mask;
+            while (mSlots[slot] >= 0) {
+                slot = (slot + 1) & mask;
+            }
+            mSlots[slot] = static_cast<int32_t>(handle);
+        }
     }
 
-    std::vector<TriangleRenderingSubmissionData> TriangleRenderingCommandList::RecordRendererSubmissionData(
-        size_t triangleBufferInstanceSizeMax) {
-        std::ranges::sort(Instances, [](const auto &a, const auto &b) {
-            if (a.Depth != b.Depth) return a.Depth < b.Depth;
-            return a.VirtualTextureID < b.VirtualTextureID;
-        });
+    enum class ClipCoverage {
+        Inside,
+        Outside,
+        Partial
+    };
 
-        std::vector<TriangleRenderingSubmissionData> submissions;
-        if (Instances.empty()) return submissions;
+    // Conservative classification of a convex primitive, given by its corners, against a clip region.
+    // Only convex clips are classified. The rest stay Partial and go through the scissor or stencil path, whose
+    // even-odd stencil fill handles concave and self-intersecting clips.
+    ClipCoverage ClassifyAgainstClip(const ClipRegion &clip, std::span<const glm::vec2> corners) {
+        const uint32_t count = clip.PointCount;
+        if (count < 3 || count > 4) {
+            return ClipCoverage::Partial;
+        }
+
+        auto cross = [](const glm::vec2 &a, const glm::vec2 &b) { return a.x * b.y - a.y * b.x; };
 
-        auto lastFrameSubmissionIt = mLastFrameCache.begin();
+        float area = 0.0f;
+        for (uint32_t i = 0; i < count; ++i) {
+            area += cross(clip.Points[i], clip.Points[(i + 1) % count]);
+        }
+        if (glm::abs(area) <= std::numeric_limits<float>::epsilon()) {
+            return ClipCoverage::Partial;
+        }
+        const float orientation = area > 0.0f ? 1.0f : -1.0f;
 
-        TriangleRenderingSubmissionData currentSubmission;
-        if (lastFrameSubmissionIt != mLastFrameCache.end()) {
-            currentSubmission = std::move(*lastFrameSubmissionIt);
-            currentSubmission.VertexData.clear();
-            currentSubmission.IndexData.clear();
-            currentSubmission.InstanceData.clear();
-            currentSubmission.ClipData.clear();
-            ++lastFrameSubmissionIt;
+        for (uint32_t i = 0; i < count; ++i) {
+            const glm::vec2 edge = clip.Points[(i + 1) % count] - clip.Points[i];
+            const glm::vec2 next = clip.Points[(i + 2) % count] - clip.Points[i];
+            if (cross(edge, next) * orientation < 0.0f) {
+                return ClipCoverage::Partial;
+            }
         }
 
-        auto finalizeSubmission = [&]() mutable {
-            if (!currentSubmission.VertexData.empty()) {
-                submissions.push_back(std::move(currentSubmission));
+        bool allInside = true;
+        for (uint32_t i = 0; i < count; ++i) {
+            const glm::vec2 &origin = clip.Points[i];
+            const glm::vec2 edge = clip.Points[(i + 1) % count] - origin;
 
-                if (lastFrameSubmissionIt == mLastFrameCache.end()) {
-                    currentSubmission.Clear();
+            bool allOutside = true;
+            for (const auto &corner: corners) {
+                if (cross(edge, corner - origin) * orientation < 0.0f) {
+                    allInside = false;
                 } else {
-                    currentSubmission = std::move(*lastFrameSubmissionIt);
-                    currentSubmission.VertexData.clear();
-                    currentSubmission.IndexData.clear();
-                    currentSubmission.InstanceData.clear();
-                    currentSubmission.ClipData.clear();
-                    ++lastFrameSubmissionIt;
+                    allOutside = false;
                 }
             }
-        };
 
-        for (const auto &instance: Instances) {
-            // check if we need to finalize due to vertex/index buffer size
-            if (currentSubmission.InstanceData.size() + 1 >
-                triangleBufferInstanceSizeMax) {
-                finalizeSubmission();
+            // The edge separates the primitive from the clip
+            if (allOutside) {
+                return ClipCoverage::Outside;
             }
+        }
 
-            int32_t finalTextureIndex = instance.VirtualTextureID;
+        return allInside ? ClipCoverage::Inside : ClipCoverage::Partial;
+    }
 
-            // Handle clip region
-            int32_t clipIndex = -1;
-            if (instance.Clip.has_value()) {
-                clipIndex = static_cast<int32_t>(currentSubmission.ClipData.size());
-                currentSubmission.ClipData.push_back(instance.Clip.value());
-            }
+    // Returns false when the primitive is fully hidden by its clip. Clears the clip when it has no visible effect.
+    bool ResolveClip(const ClipRegion *&clip, std::span<const glm::vec2> corners) {
+        if (clip == nullptr) {
+            return true;
+        }
 
-            // Fill Instance Data
-            auto instanceIndex = static_cast<uint32_t>(currentSubmission.InstanceData.size());
+        ClipCoverage coverage = ClassifyAgainstClip(*clip, corners);
+        if (coverage == ClipCoverage::Partial) {
+            return true;
+        }
 
-            currentSubmission.InstanceData.reserve(currentSubmission.InstanceData.size());
+        bool visible = (coverage == ClipCoverage::Inside) == (clip->ClipMode == ClipMode::ShowInside);
+        if (visible) {
+            clip = nullptr;
+        }
+        return visible;
+    }
 
-            currentSubmission.InstanceData.push_back({
-                .TintColor = instance.TintColor,
-                .TextureIndex = finalTextureIndex,
-                .ClipIndex = clipIndex
-            });
+    int32_t AddClipHandle(ClipRegionTable &clips, const ClipRegion *clip) {
+        return clip != nullptr ? clips.Intern(*clip) : -1;
+    }
 
-            uint32_t baseVtx = static_cast<uint32_t>(currentSubmission.VertexData.size());
+    // Appends source's keys with payloads shifted past the first baseIndex elements
+    void AppendSortKeys(std::vector<SortKey> &keys, const std::vector<SortKey> &source, size_t baseIndex) {
+        const auto base = static_cast<uint32_t>(baseIndex);
+        for (const auto &key: source) {
+            keys.push_back({key.Key, key.Payload + base});
+        }
+    }
 
-            if (!instance.IsQuad) {
-                currentSubmission.VertexData.resize(currentSubmission.VertexData.size() + 3);
-                for (int i = 0; i < 3; ++i) {
-                    TriangleVertexData *v = &currentSubmission.VertexData[baseVtx + i];
-                    v->Position = instance.Positions[i];
-                    v->TexCoords = instance.TexCoords[i];
-                    v->InstanceIndex = instanceIndex;
-                }
-                currentSubmission.IndexData.resize(currentSubmission.IndexData.size() + 3);
-                uint32_t *idx0 = &currentSubmission.IndexData[currentSubmission.IndexData.size() - 3];
-                idx0[0] = baseVtx + 0;
-                idx0[1] = baseVtx + 1;
-                idx0[2] = baseVtx + 2;
-            } else {
-                // Quad (Assume TL, TR, BR, BL)
-                currentSubmission.VertexData.resize(currentSubmission.VertexData.size() + 4);
-                for (int i = 0; i < 4; ++i) {
-                    TriangleVertexData *v = &currentSubmission.VertexData[baseVtx + i];
-                    v->Position = instance.Positions[i];
-                    v->TexCoords = instance.TexCoords[i];
-                    v->InstanceIndex = instanceIndex;
-                }
-                currentSubmission.IndexData.resize(currentSubmission.IndexData.size() + 6);
-                uint32_t *idx0 = &currentSubmission.IndexData[currentSubmission.IndexData.size() - 6];
-                idx0[0] = baseVtx + 0;
-                idx0[1] = baseVtx + 1;
-                idx0[2] = baseVtx + 2;
-                idx0[3] = baseVtx + 0;
-                idx0[4] = baseVtx + 2;
-                idx0[5] = baseVtx + 3;
+    // Appends clip handles of another list, re-interning the clips they reference in the destination table
+    void AppendClipHandles(ClipRegionTable &clips, std::vector<int32_t> &handles,
+                           const ClipRegionTable &sourceClips, const std::vector<int32_t> &sourceHandles,
+                           std::vector<int32_t> &remap) {
+        remap.clear();
+        for (const auto &region: sourceClips.Regions) {
+            remap.push_back(clips.Intern(region));
+        }
+        for (int32_t handle: sourceHandles) {
+            handles.push_back(handle < 0 ? -1 : remap[handle]);
+        }
+    }
+
+    template<typename T>
+    void AppendRange(std::vector<T> &destination, const std::vector<T> &source) {
+        destination.insert(destination.end(), source.begin(), source.end());
+    }
+
+    // Axis-aligned bounds (min x, min y, max x, max y) of a set of corners
+    glm::vec4 CornerBounds(std::span<const glm::vec2> corners) {
+        glm::vec2 min = corners.front();
+        glm::vec2 max = corners.front();
+        for (const auto &corner: corners.subspan(1)) {
+            min = glm::min(min, corner);
+            max = glm::max(max, corner);
+        }
+        return {min, max};
+    }
+
+    // Drops the keys of elements whose bounds miss visibleBounds and returns how many were dropped. Must run
+    // before sorting, while the keys are still in submission order.
+    size_t CullSortKeys(std::vector<SortKey> &keys, const std::vector<glm::vec4> &bounds,
+                        const glm::vec4 &visibleBounds) {
+        size_t kept = 0;
+#if defined(_M_X64) || defined(__SSE2__)
+        // Two rectangles overlap when (min, -max) <= (other max, -other min) in all four lanes
+        const __m128 sign = _mm_set_ps(-1.0f, -1.0f, 1.0f, 1.0f);
+        const __m128 limit = _mm_set_ps(-visibleBounds.y, -visibleBounds.x, visibleBounds.w, visibleBounds.z);
+
+        for (const auto &key: keys) {
+            const __m128 elementBounds = _mm_mul_ps(_mm_loadu_ps(&bounds[key.Payload].x), sign);
+            if (_mm_movemask_ps(_mm_cmple_ps(elementBounds, limit)) == 0xF) {
+                keys[kept++] = key;
+            }
+        }
+#else
+        for (const auto &key: keys) {
+            const glm::vec4 &elementBounds = bounds[key.Payload];
+            if (elementBounds.x <= visibleBounds.z && elementBounds.y <= visibleBounds.w &&
+                elementBounds.z >= visibleBounds.x && elementBounds.w >= visibleBounds.y) {
+                keys[kept++] = key;
             }
         }
+#endif
 
-        finalizeSubmission();
+        const size_t culled = keys.size() - kept;
+        keys.resize(kept);
+        return culled;
+    }
+
+    // Elements per chunk when expanding sorted command lists into upload buffers in parallel
+    constexpr size_t SubmissionChunkSize = 1 << 14;
+
+    // Segments per strip when a polyline is split, small enough that culling skips the off-screen parts of
+    // long polylines and large enough that the shared boundary points cost little
+    constexpr uint32_t PolylineStripSegments = 256;
+
+    // Counter-clockwise angle from start to end, where end below start wraps through pi. Equal angles or a
+    // difference of a full turn describe a closed shape.
+    float EllipseAngleSpan(float startAngle, float endAngle) {
+        constexpr float fullTurn = glm::two_pi<float>();
+        const float difference = std::abs(endAngle - startAngle);
+        if (difference <= 0.001f || difference >= fullTurn - 0.001f) {
+            return fullTurn;
+        }
 
-        return submissions;
+        const float span = std::fmod(endAngle - startAngle, fullTurn);
+        return span > 0.0f ? span : span + fullTurn;
     }
 
-    void TriangleRenderingCommandList::GiveBackForNextFrame(std::vector<TriangleRenderingSubmissionData> &&thisCache) {
-        mLastFrameCache = std::move(thisCache);
-        mLastFrameCache.resize(0);
+    uint32_t PackColor(const glm::u8vec4 &color) {
+        return static_cast<uint32_t>((color.r << 24) | (color.g << 16) | (color.b << 8) | color.a);
     }
 
-    void LineRenderingSubmissionData::Clear() {
-        VertexData.clear();
+    // Puts every element's clip handle + 1 into bits 16..31 of its key, so that sorting groups the draws sharing
+    // a clip inside each depth and every group needs one scissor rect or stencil clip. Handles past the 16 bits
+    // share the last value and are not grouped, BuildDrawSegments still splits their runs by the actual clip.
+    void ApplyClipsToSortKeys(std::vector<SortKey> &keys, const std::vector<int32_t> &clipHandles,
+                              const ClipRegionTable &clips) {
+        if (clips.Regions.empty()) {
+            return;
+        }
+
+        for (auto &key: keys) {
+            const auto clipBits = std::min<uint64_t>(static_cast<uint64_t>(clipHandles[key.Payload] + 1), 0xFFFF);
+            key.Key = (key.Key & ~0xFFFF0000ull) | (clipBits << 16);
+        }
     }
 
-    void LineRenderingCommandList::Clear() {
-        VertexData.clear();
+    // Splits the sorted elements into runs of equal depth, clip and opacity. Element i of the sort order is
+    // written at upload index first + i * stride, so every offset is known up front and chunks can be expanded
+    // independently. Textures do not split runs, they only pick the shader permutation of the whole run.
+    void BuildDrawSegments(const std::vector<SortKey> &keys, const std::vector<int32_t> &depths,
+                           const std::vector<int32_t> &clipHandles, const std::vector<int32_t> &textureIDs,
+                           uint32_t first, uint32_t stride, std::vector<DrawSegment> &segments) {
+        for (const auto &key: keys) {
+            const int32_t depth = depths[key.Payload];
+            const int32_t clip = clipHandles[key.Payload];
+            const bool opaque = (key.Key & TranslucentSortKeyBit) == 0;
+            if (segments.empty() || segments.back().Depth != depth || segments.back().Clip != clip ||
+                segments.back().Opaque != opaque) {
+                segments.push_back({depth, clip, opaque, false, first, 0});
+            }
+            segments.back().Textured = segments.back().Textured || textureIDs[key.Payload] >= 0;
+            segments.back().Count += stride;
+            first += stride;
+        }
     }
 
+    uint32_t PackUnorm2x16(const glm::vec2 &value) {
+        glm::vec2 clamped = glm::clamp(value, 0.0f, 1.0f);
+        auto x = static_cast<uint32_t>(clamped.x * 65535.0f + 0.5f);
+        auto y = static_cast<uint32_t>(clamped.y * 65535.0f + 0.5f);
+        return x | (y << 16);
+    }
 
-    void LineRenderingCommandList::AddLine(const glm::vec2 &p0, const glm::u8vec4 &color0,
-                                           const glm::vec2 &p1, const glm::u8vec4 &color1) {
-        VertexData.resize(VertexData.size() + 2);
-        LineVertexData *v0 = &VertexData[VertexData.size() - 2];
-        v0->Position = p0;
+    size_t TriangleRenderingCommandList::Size() const {
+        return Positions.size();
+    }
 
-        v0->Color = (color0.r << 24) | (color0.g << 16) | (color0.b << 8) | color0.a;
+    void TriangleRenderingCommandList::AddTriangle(const glm::vec2 &p0, const glm::vec2 &uv0,
+                                                   const glm::vec2 &p1, const glm::vec2 &uv1,
+                                                   const glm::vec2 &p2, const glm::vec2 &uv2,
+                                                   int virtualTextureID,
+                                                   uint32_t tintColor,
+                                                   int depth, const ClipRegion *clip, bool opaque) {
+        const glm::vec2 corners[] = {p0, p1, p2};
+        if (!ResolveClip(clip, corners)) {
+            return;
+        }
 
-        LineVertexData *v1 = &VertexData[VertexData.size() - 1];
-        v1->Position = p1;
-        v1->Color = (color1.r << 24) | (color1.g << 16) | (color1.b << 8) | color1.a;
+        SortKeys.push_back({MakeDrawSortKey(depth, virtualTextureID, opaque), static_cast<uint32_t>(Size())});
+        Bounds.push_back(CornerBounds(corners));
+        Positions.emplace_back(p0, p1, p2, glm::vec2{});
+        TexCoords.emplace_back(uv0, uv1, uv2, glm::vec2{});
+        TintColors.push_back(tintColor);
+        TextureIDs.push_back(virtualTextureID);
+        Depths.push_back(depth);
+        VertexCounts.push_back(3);
+        ClipHandles.push_back(AddClipHandle(Clips, clip));
     }
 
+    void TriangleRenderingCommandList::AddQuad(const glm::vec2 &p0, const glm::vec2 &uv0,
+                                               const glm::vec2 &p1, const glm::vec2 &uv1,
+                                               const glm::vec2 &p2, const glm::vec2 &uv2,
+                                               const glm::vec2 &p3, const glm::vec2 &uv3,
+                                               int virtualTextureID,
+                                               uint32_t tintColor,
+                                               int depth, const ClipRegion *clip, bool opaque) {
+        const glm::vec2 corners[] = {p0, p1, p2, p3};
+        if (!ResolveClip(clip, corners)) {
+            return;
+        }
+
+        SortKeys.push_back({MakeDrawSortKey(depth, virtualTextureID, opaque), static_cast<uint32_t>(Size())});
+        Bounds.push_back(CornerBounds(corners));
+        Positions.emplace_back(p0, p1, p2, p3);
+        TexCoords.emplace_back(uv0, uv1, uv2, uv3);
+        TintColors.push_back(tintColor);
+        TextureIDs.push_back(virtualTextureID);
+        Depths.push_back(depth);
+        VertexCounts.push_back(4);
+        ClipHandles.push_back(AddClipHandle(Clips, clip));
+    }
+
+    void TriangleRenderingCommandList::Append(const TriangleRenderingCommandList &other) {
+        AppendSortKeys(SortKeys, other.SortKeys, Size());
+        AppendRange(Bounds, other.Bounds);
+        AppendRange(Positions, other.Positions);
+        AppendRange(TexCoords, other.TexCoords);
+        AppendRange(TintColors, other.TintColors);
+        AppendRange(TextureIDs, other.TextureIDs);
+        AppendRange(Depths, other.Depths);
+        AppendRange(VertexCounts, other.VertexCounts);
+        AppendClipHandles(Clips, ClipHandles, other.Clips, other.ClipHandles, mClipRemapScratch);
+    }
 
-    std::vector<LineRenderingSubmissionData> LineRenderingCommandList::RecordRendererSubmissionData(
-        size_t lineBufferInstanceSizeMax) {
-        std::vector<LineRenderingSubmissionData> submissions;
-        if (VertexData.empty()) return submissions;
+    void TriangleRenderingCommandList::Clear() {
+        Positions.clear();
+        TexCoords.clear();
+        TintColors.clear();
+        TextureIDs.clear();
+        Depths.clear();
+        VertexCounts.clear();
+        ClipHandles.clear();
+        Clips.Clear();
+        SortKeys.clear();
+        Bounds.clear();
+    }
+
+    size_t TriangleRenderingCommandList::Cull(const glm::vec4 &visibleBounds) {
+        return CullSortKeys(SortKeys, Bounds, visibleBounds);
+    }
+
+    void TriangleRenderingCommandList::RecordRendererSubmissionData(TriangleFrameUploadBuffers &upload,
+                                                                    ThreadPool &threadPool) {
+        Segments.clear();
+        if (SortKeys.empty()) return;
+
+        ApplyClipsToSortKeys(SortKeys, ClipHandles, Clips);
+        RadixSort(SortKeys, mSortScratch);
+
+        uint32_t firstPrimitive = 0;
+        TrianglePrimitiveData *primitiveOut = upload.Primitives.Allocate(SortKeys.size(), firstPrimitive);
+
+        BuildDrawSegments(SortKeys, Depths, ClipHandles, TextureIDs, firstPrimitive, 1, Segments);
+
+        threadPool.ParallelForChunks(SortKeys.size(), SubmissionChunkSize, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                const uint32_t element = SortKeys[i].Payload;
+                const bool isQuad = VertexCounts[element] == 4;
+
+                const glm::mat4x2 &texCoords = TexCoords[element];
+                const uint32_t textureBits = static_cast<uint32_t>(TextureIDs[element] + 1) & 0x7FFFFFFF;
+
+                primitiveOut[i] = {
+                    .Positions = Positions[element],
+                    .TexCoords = {
+                        PackUnorm2x16(texCoords[0]),
+                        PackUnorm2x16(texCoords[1]),
+                        PackUnorm2x16(texCoords[2]),
+                        PackUnorm2x16(texCoords[3])
+                    },
+                    .TintColor = TintColors[element],
+                    .PackedIndices = (isQuad ? 0x80000000u : 0u) | textureBits
+                };
+            }
+        });
+    }
 
-        auto lastFrameSubmissionIt = mLastFrameCache.begin();
+    size_t SpriteRenderingCommandList::Size() const {
+        return Centers.size();
+    }
 
-        LineRenderingSubmissionData currentSubmission;
-        if (lastFrameSubmissionIt != mLastFrameCache.end()) {
-            currentSubmission = std::move(*lastFrameSubmissionIt);
-            currentSubmission.VertexData.clear();
-            ++lastFrameSubmissionIt;
-        }
+    void SpriteRenderingCommandList::Clear() {
+        Centers.clear();
+        HalfSizes.clear();
+        Rotations.clear();
+        UVRects.clear();
+        TintColors.clear();
+        TextureIDs.clear();
+        Depths.clear();
+        ClipHandles.clear();
+        Clips.Clear();
+        SortKeys.clear();
+        Bounds.clear();
+    }
 
-        auto finalizeSubmission = [&]() mutable {
-            if (!currentSubmission.VertexData.empty()) {
-                submissions.push_back(std::move(currentSubmission));
+    void SpriteRenderingCommandList::AddSprite(const glm::vec2 &center, const glm::vec2 &halfSize, float rotation,
+                                               const glm::vec4 &uvRect, int virtualTextureID,
+                                               uint32_t tintColor, int depth, const ClipRegion *clip,
+                                               bool opaque) {
+        // Same rotated rectangle the vertex shader rasterizes
+        glm::vec2 axisX = glm::vec2(glm::cos(rotation), glm::sin(rotation));
+        glm::vec2 axisY = glm::vec2(-axisX.y, axisX.x) * halfSize.y;
+        axisX *= halfSize.x;
 
-                if (lastFrameSubmissionIt == mLastFrameCache.end()) {
-                    currentSubmission.Clear();
-                } else {
-                    currentSubmission = std::move(*lastFrameSubmissionIt);
-                    currentSubmission.VertexData.clear();
-                    ++lastFrameSubmissionIt;
-                }
+        if (clip != nullptr) {
+            const glm::vec2 corners[] = {
+                center - axisX - axisY,
+                center + axisX - axisY,
+                center + axisX + axisY,
+                center - axisX + axisY
+            };
+            if (!ResolveClip(clip, corners)) {
+                return;
             }
-        };
+        }
 
-        for (const auto &vertex: VertexData) {
-            // check if we need to finalize due to vertex buffer size
-            if (currentSubmission.VertexData.size() + 1 >
-                lineBufferInstanceSizeMax) {
-                finalizeSubmission();
+        const glm::vec2 extent = glm::abs(axisX) + glm::abs(axisY);
+
+        SortKeys.push_back({MakeDrawSortKey(depth, virtualTextureID, opaque), static_cast<uint32_t>(Size())});
+        Bounds.emplace_back(center - extent, center + extent);
+        Centers.push_back(center);
+        HalfSizes.push_back(glm::packHalf2x16(halfSize));
+        Rotations.push_back(rotation);
+        UVRects.emplace_back(PackUnorm2x16(glm::vec2(uvRect.x, uvRect.y)),
+                             PackUnorm2x16(glm::vec2(uvRect.z, uvRect.w)));
+        TintColors.push_back(tintColor);
+        TextureIDs.push_back(virtualTextureID);
+        Depths.push_back(depth);
+        ClipHandles.push_back(AddClipHandle(Clips, clip));
+    }
+
+    void SpriteRenderingCommandList::Append(const SpriteRenderingCommandList &other) {
+        AppendSortKeys(SortKeys, other.SortKeys, Size());
+        AppendRange(Bounds, other.Bounds);
+        AppendRange(Centers, other.Centers);
+        AppendRange(HalfSizes, other.HalfSizes);
+        AppendRange(Rotations, other.Rotations);
+        AppendRange(UVRects, other.UVRects);
+        AppendRange(TintColors, other.TintColors);
+        AppendRange(TextureIDs, other.TextureIDs);
+        AppendRange(Depths, other.Depths);
+        AppendClipHandles(Clips, ClipHandles, other.Clips, other.ClipHandles, mClipRemapScratch);
+    }
+
+    size_t SpriteRenderingCommandList::Cull(const glm::vec4 &visibleBounds) {
+        return CullSortKeys(SortKeys, Bounds, visibleBounds);
+    }
+
+    void SpriteRenderingCommandList::RecordRendererSubmissionData(SpriteFrameUploadBuffers &upload,
+                                                                  ThreadPool &threadPool) {
+        Segments.clear();
+        if (SortKeys.empty()) return;
+
+        ApplyClipsToSortKeys(SortKeys, ClipHandles, Clips);
+        RadixSort(SortKeys, mSortScratch);
+
+        uint32_t firstPrimitive = 0;
+        SpritePrimitiveData *primitiveOut = upload.Primitives.Allocate(SortKeys.size(), firstPrimitive);
+
+        BuildDrawSegments(SortKeys, Depths, ClipHandles, TextureIDs, firstPrimitive, 1, Segments);
+
+        threadPool.ParallelForChunks(SortKeys.size(), SubmissionChunkSize, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                const uint32_t element = SortKeys[i].Payload;
+
+                primitiveOut[i] = {
+                    .Center = Centers[element],
+                    .HalfSize = HalfSizes[element],
+                    .Rotation = Rotations[element],
+                    .UVMin = UVRects[element].x,
+                    .UVMax = UVRects[element].y,
+                    .TintColor = TintColors[element],
+                    .TextureIndex = TextureIDs[element]
+                };
             }
+        });
+    }
+
+    size_t LineRenderingCommandList::Size() const {
+        return FirstPoints.size();
+    }
+
+    void LineRenderingCommandList::Clear() {
+        Points.clear();
+        FirstPoints.clear();
+        PointCounts.clear();
+        Caps.clear();
+        Depths.clear();
+        ClipHandles.clear();
+        Clips.Clear();
+        SortKeys.clear();
+        Bounds.clear();
+    }
+
+    void LineRenderingCommandList::AddLine(const glm::vec2 &p0, const glm::u8vec4 &color0,
+                                           const glm::vec2 &p1, const glm::u8vec4 &color1,
+                                           const LineStyle &style, int depth, const ClipRegion *clip) {
+        const float halfWidth = style.Width * 0.5f;
+        const auto firstPoint = static_cast<uint32_t>(Points.size());
+        Points.push_back({p0, PackColor(color0), halfWidth});
+        Points.push_back({p1, PackColor(color1), halfWidth});
+
+        AddStrip(firstPoint, 2, style.StartCap, style.EndCap, halfWidth, depth, clip);
+    }
+
+    void LineRenderingCommandList::AddPolyline(std::span<const glm::vec2> points, const glm::u8vec4 &color,
+                                               const LineStyle &style, int depth, const ClipRegion *clip) {
+        if (points.size() < 2) {
+            return;
+        }
+
+        const float halfWidth = style.Width * 0.5f;
+        const uint32_t packedColor = PackColor(color);
+        const auto firstPoint = static_cast<uint32_t>(Points.size());
+        for (const auto &point: points) {
+            Points.push_back({point, packedColor, halfWidth});
+        }
+
+        // Consecutive strips share their boundary point, the joint between them is round like the ones inside
+        const auto segmentCount = static_cast<uint32_t>(points.size() - 1);
+        for (uint32_t first = 0; first < segmentCount; first += PolylineStripSegments) {
+            const uint32_t count = std::min(PolylineStripSegments, segmentCount - first);
+            AddStrip(firstPoint + first, count + 1,
+                     first == 0 ? style.StartCap : LineCap::Round,
+                     first + count == segmentCount ? style.EndCap : LineCap::Round,
+                     halfWidth, depth, clip);
+        }
+    }
+
+    void LineRenderingCommandList::AddStrip(uint32_t firstPoint, uint32_t pointCount, LineCap startCap,
+                                            LineCap endCap, float halfWidth, int depth, const ClipRegion *clip) {
+        glm::vec2 min = Points[firstPoint].Position;
+        glm::vec2 max = min;
+        for (uint32_t i = firstPoint + 1; i < firstPoint + pointCount; ++i) {
+            min = glm::min(min, Points[i].Position);
+            max = glm::max(max, Points[i].Position);
+        }
+        // Square caps reach half the width diagonally past their end point
+        const float extent = halfWidth * glm::root_two<float>();
+        min -= extent;
+        max += extent;
 
-            currentSubmission.VertexData.push_back(vertex);
+        const glm::vec2 corners[] = {min, glm::vec2(max.x, min.y), max, glm::vec2(min.x, max.y)};
+        if (!ResolveClip(clip, corners)) {
+            return;
         }
 
-        finalizeSubmission();
+        SortKeys.push_back({MakeDrawSortKey(depth, -1), static_cast<uint32_t>(Size())});
+        Bounds.emplace_back(min, max);
+        FirstPoints.push_back(firstPoint);
+        PointCounts.push_back(pointCount);
+        Caps.push_back(static_cast<uint32_t>(startCap) | (static_cast<uint32_t>(endCap) << 2));
+        Depths.push_back(depth);
+        ClipHandles.push_back(AddClipHandle(Clips, clip));
+    }
+
+    void LineRenderingCommandList::Append(const LineRenderingCommandList &other) {
+        const auto pointBase = static_cast<uint32_t>(Points.size());
 
-        return submissions;
+        AppendSortKeys(SortKeys, other.SortKeys, Size());
+        AppendRange(Bounds, other.Bounds);
+        AppendRange(Points, other.Points);
+        for (uint32_t firstPoint: other.FirstPoints) {
+            FirstPoints.push_back(firstPoint + pointBase);
+        }
+        AppendRange(PointCounts, other.PointCounts);
+        AppendRange(Caps, other.Caps);
+        AppendRange(Depths, other.Depths);
+        AppendClipHandles(Clips, ClipHandles, other.Clips, other.ClipHandles, mClipRemapScratch);
+    }
+
+    size_t LineRenderingCommandList::Cull(const glm::vec4 &visibleBounds) {
+        return CullSortKeys(SortKeys, Bounds, visibleBounds);
     }
 
-    void LineRenderingCommandList::GiveBackForNextFrame(std::vector<LineRenderingSubmissionData> &&thisCache) {
-        mLastFrameCache = std::move(thisCache);
-        mLastFrameCache.resize(0);
+    void LineRenderingCommandList::RecordRendererSubmissionData(LineFrameUploadBuffers &upload,
+                                                                ThreadPool &threadPool) {
+        Segments.clear();
+        if (SortKeys.empty()) return;
+
+        ApplyClipsToSortKeys(SortKeys, ClipHandles, Clips);
+        RadixSort(SortKeys, mSortScratch);
+
+        // Strips differ in size, so every sorted strip gets its output offsets up front
+        mOutputOffsets.resize(SortKeys.size());
+        glm::u32vec2 total(0);
+        for (size_t i = 0; i < SortKeys.size(); ++i) {
+            mOutputOffsets[i] = total;
+            total += glm::u32vec2(PointCounts[SortKeys[i].Payload], PointCounts[SortKeys[i].Payload] - 1);
+        }
+
+        uint32_t firstPoint = 0;
+        uint32_t firstSegment = 0;
+        LinePointData *pointOut = upload.Points.Allocate(total.x, firstPoint);
+        LineSegmentData *segmentOut = upload.Segments.Allocate(total.y, firstSegment);
+
+        for (size_t i = 0; i < SortKeys.size(); ++i) {
+            const uint32_t strip = SortKeys[i].Payload;
+            if (Segments.empty() || Segments.back().Depth != Depths[strip] ||
+                Segments.back().Clip != ClipHandles[strip]) {
+                Segments.push_back({
+                    Depths[strip], ClipHandles[strip], false, false, firstSegment + mOutputOffsets[i].y, 0
+                });
+            }
+            Segments.back().Count += PointCounts[strip] - 1;
+        }
+
+        constexpr size_t stripsPerChunk = SubmissionChunkSize / PolylineStripSegments;
+        threadPool.ParallelForChunks(SortKeys.size(), stripsPerChunk, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                const uint32_t strip = SortKeys[i].Payload;
+                const uint32_t pointCount = PointCounts[strip];
+
+                std::memcpy(pointOut + mOutputOffsets[i].x, &Points[FirstPoints[strip]],
+                            sizeof(LinePointData) * pointCount);
+
+                const uint32_t startCap = Caps[strip] & 0x3;
+                const uint32_t endCap = Caps[strip] >> 2;
+                const uint32_t roundCap = static_cast<uint32_t>(LineCap::Round);
+                const uint32_t lastSegment = pointCount - 2;
+
+                LineSegmentData *out = segmentOut + mOutputOffsets[i].y;
+                for (uint32_t segment = 0; segment <= lastSegment; ++segment) {
+                    const uint32_t caps = (segment == 0 ? startCap : roundCap) |
+                                          ((segment == lastSegment ? endCap : roundCap) << 2);
+                    out[segment] = {
+                        .FirstPoint = firstPoint + mOutputOffsets[i].x + segment,
+                        .PackedStyle = caps
+                    };
+                }
+            }
+        });
     }
 
     EllipseRenderingData EllipseRenderingData::Circle(const glm::vec2 &center, float radius,
@@ -1220,9 +2496,7 @@ Engine {
         data.Radii = glm::vec2(radius, radius);
         data.TintColor = (color.r << 24) | (color.g << 16) | (color.b << 8) | color.a;
         data.Depth = depth;
-        if (clip != nullptr) {
-            data.Clip = *clip;
-        }
+        data.Clip = clip;
         return data;
     }
 
@@ -1235,9 +2509,7 @@ Engine {
         data.Rotation = rotation;
         data.TintColor = (color.r << 24) | (color.g << 16) | (color.b << 8) | color.a;
         data.Depth = depth;
-        if (clip != nullptr) {
-            data.Clip = *clip;
-        }
+        data.Clip = clip;
         return data;
     }
 
@@ -1250,9 +2522,7 @@ Engine {
         data.InnerScale = innerRadius / outerRadius;
         data.TintColor = (color.r << 24) | (color.g << 16) | (color.b << 8) | color.a;
         data.Depth = depth;
-        if (clip != nullptr) {
-            data.Clip = *clip;
-        }
+        data.Clip = clip;
         return data;
     }
 
@@ -1268,9 +2538,7 @@ Engine {
         data.VirtualTextureID = textureIndex;
         data.TintColor = (color.r << 24) | (color.g << 16) | (color.b << 8) | color.a;
         data.Depth = depth;
-        if (clip != nullptr) {
-            data.Clip = *clip;
-        }
+        data.Clip = clip;
         return data;
     }
 
@@ -1286,9 +2554,7 @@ Engine {
         data.EndAngle = endAngle;
         data.TintColor = (color.r << 24) | (color.g << 16) | (color.b << 8) | color.a;
         data.Depth = depth;
-        if (clip != nullptr) {
-            data.Clip = *clip;
-        }
+        data.Clip = clip;
         return data;
     }
 
@@ -1305,9 +2571,7 @@ Engine {
         data.VirtualTextureID = textureIndex;
         data.TintColor = (color.r << 24) | (color.g << 16) | (color.b << 8) | color.a;
         data.Depth = depth;
-        if (clip != nullptr) {
-            data.Clip = *clip;
-        }
+        data.Clip = clip;
         return data;
     }
 
@@ -1326,96 +2590,121 @@ Engine {
         data.EndAngle = endAngle;
         data.TintColor = (color.r << 24) | (color.g << 16) | (color.b << 8) | color.a;
         data.Depth = depth;
-        if (clip != nullptr) {
-            data.Clip = *clip;
-        }
+        data.Clip = clip;
         return data;
     }
 
-    void EllipseRenderingSubmissionData::Clear() {
-        ShapeData.clear();
-        ClipData.clear();
+    size_t EllipseRenderingCommandList::Size() const {
+        return Centers.size();
     }
 
     void EllipseRenderingCommandList::Clear() {
-        Instances.clear();
+        Centers.clear();
+        Radii.clear();
+        Rotations.clear();
+        InnerScales.clear();
+        Angles.clear();
+        TintColors.clear();
+        TextureIDs.clear();
+        EdgeSoftness.clear();
+        Depths.clear();
+        ClipHandles.clear();
+        Clips.Clear();
+        SortKeys.clear();
+        Bounds.clear();
     }
 
     void EllipseRenderingCommandList::AddEllipse(const EllipseRenderingData &data) {
-        Instances.push_back(data);
-    }
-
-    std::vector<EllipseRenderingSubmissionData> EllipseRenderingCommandList::RecordRendererSubmissionData(
-        size_t ellipseBufferInstanceSizeMax) {
-        std::ranges::sort(Instances, [](const EllipseRenderingData &a, const EllipseRenderingData &b)-> bool {
-            if (a.Depth != b.Depth) return a.Depth < b.Depth;
-            return a.VirtualTextureID < b.VirtualTextureID;
-        });
-
-
-        std::vector<EllipseRenderingSubmissionData> submissions;
-        if (Instances.empty()) return submissions;
-
-        auto lastFrameSubmissionIt = mLastFrameCache.begin();
-
-        EllipseRenderingSubmissionData currentSubmission;
-        if (lastFrameSubmissionIt != mLastFrameCache.end()) {
-            currentSubmission = std::move(*lastFrameSubmissionIt);
-            currentSubmission.ShapeData.clear();
-            currentSubmission.ClipData.clear();
-            ++lastFrameSubmissionIt;
-        }
-
-        auto finalizeSubmission = [&]() mutable {
-            if (!currentSubmission.ShapeData.empty()) {
-                submissions.push_back(std::move(currentSubmission));
-
-                if (lastFrameSubmissionIt == mLastFrameCache.end()) {
-                    currentSubmission.Clear();
-                } else {
-                    currentSubmission = std::move(*lastFrameSubmissionIt);
-                    currentSubmission.ShapeData.clear();
-                    currentSubmission.ClipData.clear();
-                    ++lastFrameSubmissionIt;
-                }
-            }
-        };
-
-        for (const auto &instance: Instances) {
-            if (currentSubmission.ShapeData.size() + 1 > ellipseBufferInstanceSizeMax) {
-                finalizeSubmission();
-            }
-
-            // Handle clip region
-            int32_t clipIndex = -1;
-            if (instance.Clip.has_value()) {
-                clipIndex = static_cast<int32_t>(currentSubmission.ClipData.size());
-                currentSubmission.ClipData.push_back(instance.Clip.value());
+        // Mirrors the vertex shader: the outer vertices circumscribe the ellipse grown by the anti-aliasing margin
+        // along each axis, with EllipseSegments steps over at most a full turn
+        const float margin = glm::max(data.EdgeSoftness, 0.5f) * 2.0f;
+        const glm::vec2 halfSize = (data.Radii + margin) /
+                                   std::cos(glm::pi<float>() / static_cast<float>(EllipseSegments));
+        glm::vec2 axisX = glm::vec2(glm::cos(data.Rotation), glm::sin(data.Rotation));
+        glm::vec2 axisY = glm::vec2(-axisX.y, axisX.x) * halfSize.y;
+        axisX *= halfSize.x;
+
+        const ClipRegion *clip = data.Clip;
+        if (clip != nullptr) {
+            // Rotated rectangle around everything the strip can rasterize, anti-aliasing margin included
+            const glm::vec2 corners[] = {
+                data.Center - axisX - axisY,
+                data.Center + axisX - axisY,
+                data.Center + axisX + axisY,
+                data.Center - axisX + axisY
+            };
+            if (!ResolveClip(clip, corners)) {
+                return;
             }
-
-            EllipseShapeData shapeData;
-            shapeData.Center = instance.Center;
-            shapeData.Radii = instance.Radii;
-            shapeData.Rotation = instance.Rotation;
-            shapeData.InnerScale = instance.InnerScale;
-            shapeData.StartAngle = instance.StartAngle;
-            shapeData.EndAngle = instance.EndAngle;
-            shapeData.TintColor = instance.TintColor;
-            shapeData.TextureIndex = instance.VirtualTextureID;
-            shapeData.EdgeSoftness = instance.EdgeSoftness;
-            shapeData.ClipIndex = clipIndex;
-
-            currentSubmission.ShapeData.push_back(shapeData);
         }
 
-        finalizeSubmission();
-
-        return submissions;
-    }
-
-    void EllipseRenderingCommandList::GiveBackForNextFrame(std::vector<EllipseRenderingSubmissionData> &&thisCache) {
-        mLastFrameCache = std::move(thisCache);
-        mLastFrameCache.resize(0);
+        const glm::vec2 extent = glm::abs(axisX) + glm::abs(axisY);
+
+        SortKeys.push_back({MakeDrawSortKey(data.Depth, data.VirtualTextureID), static_cast<uint32_t>(Size())});
+        Bounds.emplace_back(data.Center - extent, data.Center + extent);
+        Centers.push_back(data.Center);
+        Radii.push_back(data.Radii);
+        Rotations.push_back(data.Rotation);
+        InnerScales.push_back(data.InnerScale);
+        Angles.emplace_back(data.StartAngle, data.EndAngle);
+        TintColors.push_back(data.TintColor);
+        TextureIDs.push_back(data.VirtualTextureID);
+        EdgeSoftness.push_back(data.EdgeSoftness);
+        Depths.push_back(data.Depth);
+        ClipHandles.push_back(AddClipHandle(Clips, clip));
+    }
+
+    void EllipseRenderingCommandList::Append(const EllipseRenderingCommandList &other) {
+        AppendSortKeys(SortKeys, other.SortKeys, Size());
+        AppendRange(Bounds, other.Bounds);
+        AppendRange(Centers, other.Centers);
+        AppendRange(Radii, other.Radii);
+        AppendRange(Rotations, other.Rotations);
+        AppendRange(InnerScales, other.InnerScales);
+        AppendRange(Angles, other.Angles);
+        AppendRange(TintColors, other.TintColors);
+        AppendRange(TextureIDs, other.TextureIDs);
+        AppendRange(EdgeSoftness, other.EdgeSoftness);
+        AppendRange(Depths, other.Depths);
+        AppendClipHandles(Clips, ClipHandles, other.Clips, other.ClipHandles, mClipRemapScratch);
+    }
+
+    size_t EllipseRenderingCommandList::Cull(const glm::vec4 &visibleBounds) {
+        return CullSortKeys(SortKeys, Bounds, visibleBounds);
+    }
+
+    void EllipseRenderingCommandList::RecordRendererSubmissionData(EllipseFrameUploadBuffers &upload,
+                                                                   ThreadPool &threadPool) {
+        Segments.clear();
+        if (SortKeys.empty()) return;
+
+        ApplyClipsToSortKeys(SortKeys, ClipHandles, Clips);
+        RadixSort(SortKeys, mSortScratch);
+
+        uint32_t firstShape = 0;
+        EllipseShapeData *shapeOut = upload.Shapes.Allocate(SortKeys.size(), firstShape);
+
+        BuildDrawSegments(SortKeys, Depths, ClipHandles, TextureIDs, firstShape, 1, Segments);
+
+        threadPool.ParallelForChunks(SortKeys.size(), SubmissionChunkSize, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                const uint32_t element = SortKeys[i].Payload;
+                const float rotation = Rotations[element];
+                const glm::vec2 angles = Angles[element];
+
+                shapeOut[i] = {
+                    .Center = Centers[element],
+                    .Radii = Radii[element],
+                    .Rotation = {std::cos(rotation), std::sin(rotation)},
+                    .StartAngle = angles.x,
+                    .AngleSpan = EllipseAngleSpan(angles.x, angles.y),
+                    .InnerScale = InnerScales[element],
+                    .TintColor = TintColors[element],
+                    .TextureIndex = TextureIDs[element],
+                    .EdgeSoftness = EdgeSoftness[element]
+                };
+            }
+        });
     }
 }
 
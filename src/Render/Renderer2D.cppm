@@ -2,6 +2,9 @@ export module Render.Renderer2D;
 
 import Vendor.ApplicationAPI;
 import Core.Prelude;
+import Core.RadixSort;
+import Core.ThreadPool;
+import Render.FrameUploadBuffer;
 import Render.GeneratedShaders;
 import Render.VirtualTextureManager;
 import glm;
@@ -12,6 +15,8 @@ Engine {
         glm::u32vec2 OutputSize;
         float VirtualSizeWidth;
         nvrhi::DeviceHandle Device;
+        uint32_t FramesInFlight = 3;  // Number of frames whose upload buffers may still be read by the GPU
+        uint32_t SubmissionWorkerCount = 3;  // Threads helping the render thread build upload data, 0 for none
     };
 
     export enum class ClipMode : uint32_t {
@@ -19,6 +24,49 @@ Engine {
         ShowOutside = 1  // Clip inside
     };
 
+    export enum class LineCap : uint32_t {
+        Butt = 0,    // Ends exactly at the end point
+        Square = 1,  // Extends past the end point by half the width
+        Round = 2
+    };
+
+    export struct LineStyle {
+        float Width = 0.0f;  // Virtual units, 0 draws a hairline one output pixel wide at any scale
+        LineCap StartCap = LineCap::Butt;
+        LineCap EndCap = LineCap::Butt;
+    };
+
+    export enum class PrimitiveType : uint32_t {
+        Triangle = 0,
+        Line = 1,
+        Ellipse = 2,
+        Sprite = 3,
+        StaticBatch = 4  // A retained Renderer2D::StaticBatch, drawn as a whole
+    };
+
+    // Pipeline switches are counted only when consecutive draws change primitive type, pass or shader permutation.
+    // Overdraw is estimated from the bounds of the drawn primitives other than lines, in multiples of the visible
+    // area: translucent fill is always shaded, opaque fill is what the depth test can reject behind nearer opaque
+    // draws.
+    export struct Renderer2DStatistics {
+        uint32_t DrawCalls = 0;
+        uint32_t PipelineSwitches = 0;
+        uint32_t PlainDrawCalls = 0;       // Draws of ShaderPermutation::Plain, never sampling a texture
+        uint32_t UploadBufferGrowths = 0;  // Upload buffers that had to grow, zero in a warmed-up steady scene
+        uint32_t StaticBatchBuilds = 0;    // Static batches uploaded this frame, zero unless one was invalidated
+        uint32_t CulledPrimitives = 0;     // Draws outside the visible area, static batches count as one
+        uint32_t StencilClipWrites = 0;    // Clips rasterized into the stencil buffer, see ClipRegion
+        uint32_t OpaquePrimitives = 0;     // Drawn front to back with depth writes, see Renderer2DRecorder
+        uint32_t RetiredRenderTargets = 0; // Replaced by resizes and still waiting for their last frame
+        float ResizeMilliseconds = 0.0f;   // Spent recreating the render targets at the start of this frame
+        float OpaqueOverdraw = 0.0f;
+        float TranslucentOverdraw = 0.0f;
+    };
+
+    // Applied by the fixed-function stages, never per pixel in the shaders. A ShowInside quad that is an
+    // axis-aligned rectangle on screen becomes a scissor rect, any other clip is rasterized into the stencil
+    // buffer and tested there. Quads are filled as the fan (0, 1, 2), (0, 2, 3), so their points have to go
+    // around a convex outline.
     export struct ClipRegion {
         glm::mat4x2 Points;  // Virtual coordinates
         uint32_t PointCount;  // 3 or 4
@@ -31,138 +79,293 @@ Engine {
                                         Engine::ClipMode clipMode = Engine::ClipMode::ShowInside);
     };
 
-    struct TriangleVertexData {
-        glm::vec2 Position;
-        glm::vec2 TexCoords;
-        uint32_t InstanceIndex;
+    struct ClipRegionHash {
+        size_t operator()(const ClipRegion &clip) const;
     };
 
-    struct TriangleInstanceData {
-        uint32_t TintColor;
-        int32_t TextureIndex;
-        int32_t ClipIndex;  // < 0 means no clipping
+    struct ClipRegionEqual {
+        bool operator()(const ClipRegion &lhs, const ClipRegion &rhs) const;
     };
 
-    struct VertexPosition {
-        glm::vec2 Position;
-        glm::vec2 TexCoords;
+    // Deduplicated clip regions of one frame, a handle is the index into Regions.
+    // Lookup is an open addressing table of handles that keeps its storage across Clear().
+    struct ClipRegionTable {
+        std::vector<ClipRegion> Regions;
+
+        int32_t Intern(const ClipRegion &clip);
+
+        void Clear();
+
+    private:
+        void Rehash(size_t slotCount);
+
+        std::vector<int32_t> mSlots;  // -1 marks an empty slot, size is a power of two
+        int32_t mLastHandle = -1;
     };
 
-    struct TriangleRenderingData {
-        glm::mat4x2 Positions;
-        glm::mat4x2 TexCoords;
-        bool IsQuad;
-        int VirtualTextureID;
-        uint32_t TintColor;
+    // Contiguous range sharing the same depth, clip and opacity. First/Count are indices, vertices or shapes
+    // within the frame's upload buffers.
+    struct DrawSegment {
         int Depth;
-        std::optional<ClipRegion> Clip;
-
-        static TriangleRenderingData Triangle(const glm::vec2 &p0, const glm::vec2 &uv0,
-                                              const glm::vec2 &p1, const glm::vec2 &uv1,
-                                              const glm::vec2 &p2, const glm::vec2 &uv2,
-                                              int textureIndex, uint32_t tintColor, int depth = 0,
-                                              const ClipRegion* clip = nullptr);
-
-        static TriangleRenderingData Quad(const glm::vec2 &p0, const glm::vec2 &uv0,
-                                          const glm::vec2 &p1, const glm::vec2 &uv1,
-                                          const glm::vec2 &p2, const glm::vec2 &uv2,
-                                          const glm::vec2 &p3, const glm::vec2 &uv3,
-                                          int virtualTextureID, uint32_t tintColor, int depth = 0,
-                                          const ClipRegion* clip = nullptr);
+        int32_t Clip;  // Handle into the command list's clip table, < 0 means no clipping
+        bool Opaque;
+        bool Textured;  // Any element of the range samples a texture
+        uint32_t First;
+        uint32_t Count;
+    };
+
+    struct DrawStreamEntry {
+        int Depth;
+        PrimitiveType Type;
+        uint32_t First;
+        uint32_t Count;
+        int32_t Clip = -1;  // Handle into the frame's or the static batch's clip table, < 0 means no clipping
+        bool Opaque = false;
+        bool Textured = false;
+        uint32_t FirstOrdinal = 0;  // Position of the first primitive in the draw order, sets its depth value
+    };
+
+    // Opaque draws go first, front to back with depth writes, so they only shade the pixels no nearer opaque
+    // draw covers. Everything else follows back to front, depth tested against them.
+    enum class DrawPass : uint8_t {
+        Opaque = 0,
+        Translucent = 1,
+        Count
     };
 
-    struct TriangleRenderingSubmissionData {
-        std::vector<TriangleVertexData> VertexData;
-        std::vector<uint32_t> IndexData;
-        std::vector<TriangleInstanceData> InstanceData;
-        std::vector<ClipRegion> ClipData;  // Index 0 is reserved for "no clip"
+    // Pixel shader build of a pipeline variant. Plain draws have no texture at all and run a shader without the
+    // per-pixel texture branch, which is the common case for shapes and UI. Draws are never split by texture, a
+    // range mixing both kinds takes the textured build, which still branches per primitive.
+    enum class ShaderPermutation : uint8_t {
+        Plain = 0,
+        Textured = 1,
+        Count
+    };
 
-        TriangleRenderingSubmissionData() = default;
+    // Push constants of the primitive pipelines. The n-th primitive of the draw order gets the depth value
+    // 1 - (n + 1) * OrdinalScale, which the vertex shaders compute from their primitive index plus
+    // OrdinalOffset. Later primitives are nearer, so the depth test reproduces the painter's order.
+    struct DepthConstants {
+        int32_t OrdinalOffset;
+        float OrdinalScale;
+    };
 
-        TriangleRenderingSubmissionData(TriangleRenderingSubmissionData &&) = default;
+    // Stencil test of a pipeline variant, stencil clipped draws compare against the clip's reference value
+    enum class ClipStencilTest : uint8_t {
+        None = 0,
+        Inside = 1,   // Equal, for ClipMode::ShowInside
+        Outside = 2,  // Not equal, for ClipMode::ShowOutside
+        Count
+    };
 
-        TriangleRenderingSubmissionData &operator=(TriangleRenderingSubmissionData &&) = default;
+    // Fixed-function state a draw's clip resolves to
+    struct ClipState {
+        ClipStencilTest StencilTest = ClipStencilTest::None;
+        uint8_t StencilReference = 0;
+        nvrhi::Rect Scissor;
 
-        void Clear();
+        bool operator==(const ClipState &other) const = default;
     };
 
+    // One triangle or quad, fetched by the vertex shader through SV_VertexID / 6
+    struct TrianglePrimitiveData {
+        glm::mat4x2 Positions;
+        uint32_t TexCoords[4];   // unorm16x2, u in the low half
+        uint32_t TintColor;
+        uint32_t PackedIndices;  // bit 31: quad, bits 0..30: texture index + 1
+    };
+
+    struct TriangleFrameUploadBuffers {
+        FrameUploadBuffer<TrianglePrimitiveData> Primitives;
+    };
+
+    // Structure-of-arrays storage, element i of every array describes the i-th triangle or quad
     struct TriangleRenderingCommandList {
-        std::vector<TriangleRenderingData> Instances;
+        std::vector<glm::mat4x2> Positions;
+        std::vector<glm::mat4x2> TexCoords;
+        std::vector<uint32_t> TintColors;
+        std::vector<int32_t> TextureIDs;
+        std::vector<int32_t> Depths;
+        std::vector<uint8_t> VertexCounts;  // 3 or 4
+        std::vector<int32_t> ClipHandles;   // < 0 means no clipping, otherwise indexes Clips
+        ClipRegionTable Clips;              // Only clipped draws reference an entry here
+        std::vector<glm::vec4> Bounds;      // Virtual space (min x, min y, max x, max y)
+        std::vector<SortKey> SortKeys;      // (depth, clip, opacity, texture) key, payload is the element index
+        std::vector<DrawSegment> Segments;  // Output of RecordRendererSubmissionData, in primitives
+
+        [[nodiscard]] size_t Size() const;
 
         void Clear();
 
+        // opaque marks draws whose every covered pixel ends up with an alpha of 1, they are drawn in
+        // DrawPass::Opaque
         void AddTriangle(const glm::vec2 &p0, const glm::vec2 &uv0,
                          const glm::vec2 &p1, const glm::vec2 &uv1,
                          const glm::vec2 &p2, const glm::vec2 &uv2,
                          int virtualTextureID, uint32_t tintColor, int depth,
-                         const ClipRegion* clip = nullptr);
+                         const ClipRegion* clip = nullptr, bool opaque = false);
 
         void AddQuad(const glm::vec2 &p0, const glm::vec2 &uv0,
                      const glm::vec2 &p1, const glm::vec2 &uv1,
                      const glm::vec2 &p2, const glm::vec2 &uv2,
                      const glm::vec2 &p3, const glm::vec2 &uv3,
                      int virtualTextureID, uint32_t tintColor, int depth,
-                     const ClipRegion* clip = nullptr);
+                     const ClipRegion* clip = nullptr, bool opaque = false);
+
+        // Appends other's draws after this list's, as if they had been added here in the same order
+        void Append(const TriangleRenderingCommandList &other);
+
+        // Drops the draws whose bounds miss visibleBounds so they are neither sorted nor uploaded, returns how
+        // many were dropped. Call before RecordRendererSubmissionData.
+        size_t Cull(const glm::vec4 &visibleBounds);
 
-        std::vector<TriangleRenderingSubmissionData> RecordRendererSubmissionData(size_t triangleBufferInstanceSizeMax);
+        // Writes the sorted draws straight into this frame's upload buffers and fills Segments. Large lists are
+        // expanded in chunks on threadPool, the output does not depend on the number of threads.
+        void RecordRendererSubmissionData(TriangleFrameUploadBuffers &upload, ThreadPool &threadPool);
 
-        void GiveBackForNextFrame(std::vector<TriangleRenderingSubmissionData> &&thisCache);
+    private:
+        std::vector<SortKey> mSortScratch;
+        std::vector<int32_t> mClipRemapScratch;
+    };
+
+    // One rectangle, fetched by the sprite vertex shader through SV_VertexID / 6. Kept at 32 bytes, the half
+    // size is stored at half precision, which is exact for the pixel sizes sprites usually have.
+    struct SpritePrimitiveData {
+        glm::vec2 Center;
+        uint32_t HalfSize;       // half2, x in the low half
+        float Rotation;          // Radians, counter-clockwise in virtual space
+        uint32_t UVMin;          // unorm16x2, u in the low half
+        uint32_t UVMax;          // unorm16x2, u in the low half
+        uint32_t TintColor;
+        int32_t TextureIndex;    // < 0 means untextured
+    };
+
+    struct SpriteFrameUploadBuffers {
+        FrameUploadBuffer<SpritePrimitiveData> Primitives;
+    };
+
+    // Structure-of-arrays storage, element i of every array describes the i-th sprite
+    struct SpriteRenderingCommandList {
+        std::vector<glm::vec2> Centers;
+        std::vector<uint32_t> HalfSizes;    // half2, packed when the sprite is added
+        std::vector<float> Rotations;
+        std::vector<glm::u32vec2> UVRects;  // unorm16x2 min, max
+        std::vector<uint32_t> TintColors;
+        std::vector<int32_t> TextureIDs;
+        std::vector<int32_t> Depths;
+        std::vector<int32_t> ClipHandles;   // < 0 means no clipping, otherwise indexes Clips
+        ClipRegionTable Clips;              // Only clipped draws reference an entry here
+        std::vector<glm::vec4> Bounds;      // Virtual space (min x, min y, max x, max y)
+        std::vector<SortKey> SortKeys;      // (depth, clip, opacity, texture) key, payload is the element index
+        std::vector<DrawSegment> Segments;  // Output of RecordRendererSubmissionData, in sprites
+
+        [[nodiscard]] size_t Size() const;
+
+        void Clear();
+
+        // uvRect is (min u, min v, max u, max v), min maps to the corner at -halfSize before rotation
+        void AddSprite(const glm::vec2 &center, const glm::vec2 &halfSize, float rotation,
+                       const glm::vec4 &uvRect, int virtualTextureID, uint32_t tintColor, int depth,
+                       const ClipRegion* clip = nullptr, bool opaque = false);
+
+        // Appends other's sprites after this list's, as if they had been added here in the same order
+        void Append(const SpriteRenderingCommandList &other);
+
+        // Same as TriangleRenderingCommandList::Cull
+        size_t Cull(const glm::vec4 &visibleBounds);
+
+        // Writes the sorted sprites straight into this frame's upload buffers and fills Segments, see
+        // TriangleRenderingCommandList for the threading
+        void RecordRendererSubmissionData(SpriteFrameUploadBuffers &upload, ThreadPool &threadPool);
 
     private:
-        std::vector<TriangleRenderingSubmissionData> mLastFrameCache;
+        std::vector<SortKey> mSortScratch;
+        std::vector<int32_t> mClipRemapScratch;
     };
 
-    struct TriangleBatchRenderingResources {
-        nvrhi::BufferHandle VertexBuffer;
-        nvrhi::BufferHandle IndexBuffer;
-        nvrhi::BufferHandle InstanceBuffer;
-        nvrhi::BufferHandle ClipBuffer;  // ClipRegion buffer
-        nvrhi::BindingSetHandle mBindingSetSpace0;
+    // Constants of the line pipeline, the other pipelines only read the matrix
+    struct LineConstants {
+        glm::mat4 ViewProjection;
+        float PixelSize;  // Virtual units per output pixel, sizes hairlines and the anti-aliased edge
+        float Padding[3];
     };
 
-    struct LineVertexData {
+    // Polyline point, shared by the segments on both of its sides
+    struct LinePointData {
         glm::vec2 Position;
         uint32_t Color;
+        float HalfWidth;  // 0 for hairlines
     };
 
-    struct LineRenderingSubmissionData {
-        std::vector<LineVertexData> VertexData;
+    // Segment from point FirstPoint to FirstPoint + 1, expanded to a quad by the line vertex shader through
+    // SV_VertexID / 6 and shaded with a signed distance to get anti-aliased edges and caps
+    struct LineSegmentData {
+        uint32_t FirstPoint;
+        uint32_t PackedStyle;  // bits 0..1: start cap, bits 2..3: end cap
+    };
 
-        void Clear();
+    struct LineFrameUploadBuffers {
+        FrameUploadBuffer<LinePointData> Points;
+        FrameUploadBuffer<LineSegmentData> Segments;
     };
 
+    // Structure-of-arrays storage, element i of every array describes the i-th strip, a run of connected
+    // segments over consecutive points. Long polylines are split into several strips sharing their boundary
+    // points, so that culling can skip the parts that are off screen.
     struct LineRenderingCommandList {
-        std::vector<LineVertexData> VertexData;
+        std::vector<LinePointData> Points;
+        std::vector<uint32_t> FirstPoints;
+        std::vector<uint32_t> PointCounts;  // At least 2
+        std::vector<uint32_t> Caps;         // Start cap | end cap << 2, joints inside a strip are round
+        std::vector<int32_t> Depths;
+        std::vector<int32_t> ClipHandles;   // < 0 means no clipping, otherwise indexes Clips
+        ClipRegionTable Clips;              // Only clipped draws reference an entry here
+        std::vector<glm::vec4> Bounds;      // Virtual space (min x, min y, max x, max y)
+        std::vector<SortKey> SortKeys;      // depth key, payload is the strip index
+        std::vector<DrawSegment> Segments;  // Output of RecordRendererSubmissionData, in line segments
+
+        [[nodiscard]] size_t Size() const;
 
         void Clear();
 
         void AddLine(const glm::vec2 &p0, const glm::u8vec4 &color0,
-                     const glm::vec2 &p1, const glm::u8vec4 &color1);
+                     const glm::vec2 &p1, const glm::u8vec4 &color1,
+                     const LineStyle &style, int depth, const ClipRegion* clip = nullptr);
+
+        // Uploads every point once, however many strips the polyline is split into
+        void AddPolyline(std::span<const glm::vec2> points, const glm::u8vec4 &color,
+                         const LineStyle &style, int depth, const ClipRegion* clip = nullptr);
 
-        std::vector<LineRenderingSubmissionData> RecordRendererSubmissionData(size_t lineBufferInstanceSizeMax);
+        // Appends other's strips after this list's, as if they had been added here in the same order
+        void Append(const LineRenderingCommandList &other);
 
-        void GiveBackForNextFrame(std::vector<LineRenderingSubmissionData> &&thisCache);
+        // Same as TriangleRenderingCommandList::Cull, per strip
+        size_t Cull(const glm::vec4 &visibleBounds);
+
+        // Writes the sorted strips straight into this frame's upload buffers and fills Segments, see
+        // TriangleRenderingCommandList for the threading
+        void RecordRendererSubmissionData(LineFrameUploadBuffers &upload, ThreadPool &threadPool);
 
     private:
-        std::vector<LineRenderingSubmissionData> mLastFrameCache;
-    };
+        void AddStrip(uint32_t firstPoint, uint32_t pointCount, LineCap startCap, LineCap endCap,
+                      float halfWidth, int depth, const ClipRegion *clip);
 
-    struct LineBatchRenderingResources {
-        nvrhi::BufferHandle VertexBuffer;
-        nvrhi::BindingSetHandle mBindingSetSpace0;
+        std::vector<SortKey> mSortScratch;
+        std::vector<int32_t> mClipRemapScratch;
+        std::vector<glm::u32vec2> mOutputOffsets;  // First point and first segment of each sorted strip
     };
 
+    // The rotation and angle range are resolved once per shape here, so the shaders do no trigonometry per pixel
     struct EllipseShapeData {
         glm::vec2 Center;
         glm::vec2 Radii;
-        float Rotation;
-        float InnerScale;
+        glm::vec2 Rotation;  // cos, sin
         float StartAngle;
-        float EndAngle;
+        float AngleSpan;     // Counter-clockwise from StartAngle, 2 pi for closed shapes
+        float InnerScale;
         uint32_t TintColor;
         int32_t TextureIndex;
         float EdgeSoftness;
-        int32_t ClipIndex;  // < 0 means no clipping
     };
 
     struct EllipseRenderingData {
@@ -176,7 +379,7 @@ Engine {
         uint32_t TintColor = 0xFFFFFFFF;
         float EdgeSoftness = 1.0f;
         int Depth = 0;
-        std::optional<ClipRegion> Clip;
+        const ClipRegion *Clip = nullptr;
 
         static EllipseRenderingData Circle(const glm::vec2 &center, float radius,
                                            const glm::u8vec4 &color, int depth = 0,
@@ -212,63 +415,104 @@ Engine {
                                                const ClipRegion* clip = nullptr);
     };
 
-    struct EllipseRenderingSubmissionData {
-        std::vector<EllipseShapeData> ShapeData;
-        std::vector<ClipRegion> ClipData;  // Index 0 is reserved for "no clip"
-
-        EllipseRenderingSubmissionData() = default;
-
-        EllipseRenderingSubmissionData(EllipseRenderingSubmissionData &&) = default;
-
-        EllipseRenderingSubmissionData &operator=(EllipseRenderingSubmissionData &&) = default;
-
-        void Clear();
+    struct EllipseFrameUploadBuffers {
+        FrameUploadBuffer<EllipseShapeData> Shapes;
     };
 
+    // Structure-of-arrays storage, element i of every array describes the i-th ellipse
     struct EllipseRenderingCommandList {
-        std::vector<EllipseRenderingData> Instances;
+        std::vector<glm::vec2> Centers;
+        std::vector<glm::vec2> Radii;
+        std::vector<float> Rotations;
+        std::vector<float> InnerScales;
+        std::vector<glm::vec2> Angles;  // start, end
+        std::vector<uint32_t> TintColors;
+        std::vector<int32_t> TextureIDs;
+        std::vector<float> EdgeSoftness;
+        std::vector<int32_t> Depths;
+        std::vector<int32_t> ClipHandles;   // < 0 means no clipping, otherwise indexes Clips
+        ClipRegionTable Clips;              // Only clipped draws reference an entry here
+        std::vector<glm::vec4> Bounds;      // Virtual space (min x, min y, max x, max y)
+        std::vector<SortKey> SortKeys;      // (depth, clip, texture) key, payload is the element index
+        std::vector<DrawSegment> Segments;  // Output of RecordRendererSubmissionData, in shapes
+
+        [[nodiscard]] size_t Size() const;
 
         void Clear();
 
         void AddEllipse(const EllipseRenderingData &data);
 
-        std::vector<EllipseRenderingSubmissionData> RecordRendererSubmissionData(size_t ellipseBufferInstanceSizeMax);
+        // Appends other's shapes after this list's, as if they had been added here in the same order
+        void Append(const EllipseRenderingCommandList &other);
+
+        // Same as TriangleRenderingCommandList::Cull
+        size_t Cull(const glm::vec4 &visibleBounds);
 
-        void GiveBackForNextFrame(std::vector<EllipseRenderingSubmissionData> &&thisCache);
+        // Writes the sorted shapes straight into this frame's upload buffers and fills Segments, see
+        // TriangleRenderingCommandList for the threading
+        void RecordRendererSubmissionData(EllipseFrameUploadBuffers &upload, ThreadPool &threadPool);
 
     private:
-        std::vector<EllipseRenderingSubmissionData> mLastFrameCache;
+        std::vector<SortKey> mSortScratch;
+        std::vector<int32_t> mClipRemapScratch;
     };
 
-    struct EllipseBatchRenderingResources {
-        nvrhi::BufferHandle ShapeBuffer;
-        nvrhi::BufferHandle ClipBuffer;  // ClipRegion buffer
-        nvrhi::BindingSetHandle mBindingSetSpace0;
+    // Per frame in flight state. The space0 binding sets point at that frame's upload buffers and are rebuilt
+    // when one of those buffers grows.
+    struct FrameRenderingResources {
+        nvrhi::EventQueryHandle CompletionQuery;
+        nvrhi::BindingSetHandle TriangleBindingSetSpace0;
+        nvrhi::BindingSetHandle EllipseBindingSetSpace0;
+        nvrhi::BindingSetHandle SpriteBindingSetSpace0;
+        nvrhi::BindingSetHandle LineBindingSetSpace0;
+        nvrhi::IBuffer *TrianglePrimitiveBuffer = nullptr;
+        nvrhi::IBuffer *EllipseShapeBuffer = nullptr;
+        nvrhi::IBuffer *SpritePrimitiveBuffer = nullptr;
+        nvrhi::IBuffer *LinePointBuffer = nullptr;
+        nvrhi::IBuffer *LineSegmentBuffer = nullptr;
     };
 
-    export class Renderer2D {
+    export class Renderer2D;
+
+    // Draw API with its own command lists, depth and clip stack. Renderer2D is the recorder of the render thread,
+    // additional recorders for worker threads come from Renderer2D::GetRecorder.
+    //
+    // Triangles, quads and sprites with a tint alpha of 255 are opaque when they are untextured or their texture
+    // was registered as opaque. Opaque draws may be reordered with the translucent draws of the same depth and
+    // always end up below them. Lines and ellipses have anti-aliased edges and are never opaque.
+    export class Renderer2DRecorder {
     public:
-        Renderer2D(const Renderer2DDescriptor& desc);
+        Renderer2DRecorder(VirtualTextureManager *virtualTextureManager, std::mutex *textureMutex);
 
-        [[nodiscard]] const glm::vec2& BeginRendering(const nvrhi::Color& clearColor = nvrhi::Color(0, 0, 0, 0));
+        Renderer2DRecorder(const Renderer2DRecorder &) = delete;
 
-        const nvrhi::CommandListHandle& GetCommandList() const;
+        Renderer2DRecorder &operator=(const Renderer2DRecorder &) = delete;
 
-        void EndRendering();
+        void Clear();
 
-        void OnResize(uint32_t width, uint32_t height);
+        [[nodiscard]] int GetCurrentDepth() const;
 
-        const glm::vec2& SetVirtualWidth(float virtualWidth);
+        void SetCurrentDepth(int depth);
 
-        [[nodiscard]] nvrhi::ITexture *GetTexture() const;
+        // Draws that do not pass an explicit clip use the innermost pushed clip of the same recorder. Clips replace
+        // rather than intersect the outer one. The stack is reset by BeginRendering.
+        void PushClip(const ClipRegion &clip);
 
-        void Clear();
+        void PopClip();
 
-        [[nodiscard]] int GetCurrentDepth() const;
+        [[nodiscard]] const ClipRegion *GetCurrentClip() const;
 
-        void SetCurrentDepth(int depth);
+        // ID for the TextureVirtual draws of this frame, looked up by a hash of the texture. opaque promises an
+        // alpha of 1 in every texel, see VirtualTextureManager::RegisterTexture.
+        uint32_t RegisterVirtualTextureForThisFrame(const nvrhi::TextureHandle &texture, bool opaque = false);
+
+        // Handle that can be cached across frames. The texture keeps its slot as long as it is drawn every few
+        // frames, ResolveVirtualTexture then turns the handle into an ID without a hash lookup.
+        VirtualTextureHandle RegisterVirtualTexture(const nvrhi::TextureHandle &texture, bool opaque = false);
 
-        uint32_t RegisterVirtualTextureForThisFrame(const nvrhi::TextureHandle &texture);
+        // ID of handle's texture, or empty once the texture was evicted for not being drawn. Register the
+        // texture again in that case.
+        [[nodiscard]] std::optional<uint32_t> ResolveVirtualTexture(VirtualTextureHandle handle) const;
 
         void DrawTriangleColored(const glm::mat3x2 &positions, const glm::u8vec4 &color,
                                  std::optional<int> overrideDepth = std::nullopt,
@@ -300,10 +544,45 @@ Engine {
                                         glm::u8vec4 tintColor = glm::u8vec4(255, 255, 255, 255),
                                         const ClipRegion* clip = nullptr);
 
-        void DrawLine(const glm::vec2 &p0, const glm::vec2 &p1, const glm::u8vec4 &color);
+        // Sprites are rectangles of the given size centered on center and rotated by rotation radians. They cost
+        // 32 bytes each instead of the 56 of a quad and are expanded on the GPU.
+        void DrawSpriteColored(const glm::vec2 &center, const glm::vec2 &size, float rotation,
+                               const glm::u8vec4 &color, std::optional<int> overrideDepth = std::nullopt,
+                               const ClipRegion* clip = nullptr);
+
+        // uvRect is (min u, min v, max u, max v)
+        void DrawSpriteTextureVirtual(const glm::vec2 &center, const glm::vec2 &size, float rotation,
+                                      uint32_t virtualTextureID,
+                                      const glm::vec4 &uvRect = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f),
+                                      std::optional<int> overrideDepth = std::nullopt,
+                                      glm::u8vec4 tintColor = glm::u8vec4(255, 255, 255, 255),
+                                      const ClipRegion* clip = nullptr);
+
+        uint32_t DrawSpriteTextureManaged(const glm::vec2 &center, const glm::vec2 &size, float rotation,
+                                          const nvrhi::TextureHandle &texture,
+                                          const glm::vec4 &uvRect = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f),
+                                          std::optional<int> overrideDepth = std::nullopt,
+                                          glm::u8vec4 tintColor = glm::u8vec4(255, 255, 255, 255),
+                                          const ClipRegion* clip = nullptr);
+
+        // Hairlines, one output pixel wide with butt caps
+        void DrawLine(const glm::vec2 &p0, const glm::vec2 &p1, const glm::u8vec4 &color,
+                      std::optional<int> overrideDepth = std::nullopt);
 
         void DrawLine(const glm::vec2 &p0, const glm::vec2 &p1,
-                      const glm::u8vec4 &color0, const glm::u8vec4 &color1);
+                      const glm::u8vec4 &color0, const glm::u8vec4 &color1,
+                      std::optional<int> overrideDepth = std::nullopt);
+
+        // Anti-aliased line of style.Width with the given caps
+        void DrawLine(const glm::vec2 &p0, const glm::vec2 &p1, const glm::u8vec4 &color,
+                      const LineStyle &style, std::optional<int> overrideDepth = std::nullopt,
+                      const ClipRegion* clip = nullptr);
+
+        // Connected segments through points with round joints. The caps apply to the first and last point.
+        // Translucent polylines blend twice where consecutive segments overlap at the joints.
+        void DrawPolyline(std::span<const glm::vec2> points, const glm::u8vec4 &color,
+                          const LineStyle &style = {}, std::optional<int> overrideDepth = std::nullopt,
+                          const ClipRegion* clip = nullptr);
 
         void DrawCircle(const glm::vec2 &center, float radius, const glm::u8vec4 &color,
                         std::optional<int> overrideDepth = std::nullopt,
@@ -377,16 +656,130 @@ Engine {
                                            std::optional<int> overrideDepth = std::nullopt,
                                            const ClipRegion* clip = nullptr);
 
-    private:
-        void CreateResources();
+    protected:
+        friend class Renderer2D;
+
+        [[nodiscard]] const ClipRegion *ActiveClip(const ClipRegion *clip) const;
+
+        // Whether a triangle, quad or sprite with this tint and texture can go to the opaque pass
+        [[nodiscard]] bool IsOpaqueDraw(const glm::u8vec4 &tintColor, int virtualTextureID) const;
 
-        void CreatePipelineResources();
+        void BeginFrame();
 
-        void CreateTriangleBatchRenderingResources(size_t count);
+        // Appends another recorder's draws after this one's
+        void Append(const Renderer2DRecorder &other);
 
-        void CreateLineBatchRenderingResources(size_t count);
+        // Owned by the renderer and shared by all of its recorders, the mutex guards texture registration
+        VirtualTextureManager *mSharedVirtualTextureManager;
+        std::mutex *mSharedVirtualTextureMutex;
+        bool mGrowTexturesOnDemand = false;  // Only for ID-only tables that no other thread reads, see StaticBatch
 
-        void CreateEllipseBatchRenderingResources(size_t count);
+        int mCurrentDepth = 0;
+        std::vector<ClipRegion> mClipStack;
+
+        TriangleRenderingCommandList mTriangleCommandList;
+        LineRenderingCommandList mLineCommandList;
+        EllipseRenderingCommandList mEllipseCommandList;
+        SpriteRenderingCommandList mSpriteCommandList;
+    };
+
+    export class Renderer2D : public Renderer2DRecorder {
+    public:
+        // Draws recorded once and kept in GPU memory. Recording uses the regular Draw* API, the batch is uploaded
+        // the first time it is drawn and again only after Invalidate. Texture IDs are local to the batch: use the
+        // TextureManaged draws, or the batch's own RegisterVirtualTextureForThisFrame for the TextureVirtual ones.
+        // Depths order the draws inside the batch, the batch as a whole is drawn at a single depth.
+        class StaticBatch : public Renderer2DRecorder {
+        public:
+            explicit StaticBatch(nvrhi::IDevice *device);
+
+            // Rebuilds the batch from its recorded draws the next time it is drawn. Call Clear() before recording
+            // to replace the content instead of adding to it.
+            void Invalidate();
+
+            // Discards the recorded draws and the batch-local texture IDs they used
+            void Clear();
+
+        private:
+            friend class Renderer2D;
+
+            // GPU copy of one primitive type, Data holds the segments for lines
+            struct PrimitiveBuffers {
+                nvrhi::BufferHandle Data;
+                nvrhi::BufferHandle Points;  // Lines only
+                nvrhi::BindingSetHandle BindingSetSpace0;
+            };
+
+            VirtualTextureManager mLocalTextures;
+            std::mutex mLocalTextureMutex;
+
+            bool mIsDirty = true;
+            std::vector<VirtualTextureHandle> mTextureHandles;  // Renderer slots baked into the buffers
+            std::array<PrimitiveBuffers, 4> mPrimitives;  // Indexed by PrimitiveType
+            glm::vec4 mBounds{};                          // Union of the draws' bounds in batch coordinates
+            std::vector<DrawStreamEntry> mDrawStream;      // Sorted by batch-local depth, then type, and merged
+            ClipRegionTable mClips;                       // In batch coordinates, referenced by mDrawStream
+            uint32_t mPrimitiveCount = 0;                 // Ordinals the batch takes up in the frame's draw order
+            uint32_t mOpaquePrimitiveCount = 0;
+            glm::vec2 mCoveredArea{};                     // Opaque, translucent, in batch units
+        };
+
+        Renderer2D(const Renderer2DDescriptor& desc);
+
+        [[nodiscard]] const glm::vec2& BeginRendering(const nvrhi::Color& clearColor = nvrhi::Color(0, 0, 0, 0));
+
+        const nvrhi::CommandListHandle& GetCommandList() const;
+
+        void EndRendering();
+
+        // Takes effect at the next BeginRendering, so any number of resizes between two frames recreate the render
+        // targets once. The previous targets are released when the frames that used them have completed, the
+        // device is never idled. GetTexture() returns the previous texture until then.
+        void OnResize(uint32_t width, uint32_t height);
+
+        const glm::vec2& SetVirtualWidth(float virtualWidth);
+
+        [[nodiscard]] nvrhi::ITexture *GetTexture() const;
+
+        // Discards everything recorded this frame, on the renderer and on every recorder
+        void Clear();
+
+        [[nodiscard]] const Renderer2DStatistics &GetStatistics() const;
+
+        // Virtual rectangle covered by the output, (min x, min y, max x, max y). Draws outside it are culled on
+        // the CPU, callers with large worlds can use it to query their own spatial index, see UniformGrid.
+        [[nodiscard]] const glm::vec4 &GetVisibleBounds() const;
+
+        // Recording context for one producer thread, created on first use. A recorder must only be used by one
+        // thread at a time and all recording has to finish before EndRendering. Recorders are merged after the
+        // draws recorded on the renderer itself, in index order, so the frame does not depend on thread timing.
+        [[nodiscard]] Renderer2DRecorder &GetRecorder(uint32_t index);
+
+        // transform maps batch coordinates to virtual coordinates. The batch must stay alive until EndRendering.
+        void DrawStaticBatch(StaticBatch &batch, const glm::mat3 &transform = glm::mat3(1.0f),
+                             std::optional<int> overrideDepth = std::nullopt);
+
+    private:
+        using PipelineVariants = std::array<std::array<std::array<nvrhi::GraphicsPipelineHandle,
+                                                                  static_cast<size_t>(ClipStencilTest::Count)>,
+                                                       static_cast<size_t>(DrawPass::Count)>,
+                                            static_cast<size_t>(ShaderPermutation::Count)>;
+        using PixelShaderPermutations = std::array<nvrhi::ShaderHandle,
+                                                   static_cast<size_t>(ShaderPermutation::Count)>;
+
+        struct StaticBatchDraw {
+            StaticBatch *Batch;
+            glm::mat4 Model;
+            int Depth;
+            uint32_t FirstOrdinal = 0;
+        };
+
+        void CreateResources();
+
+        // Retires the render targets of the previous size and creates new ones, see OnResize
+        void RecreateRenderTargets();
+
+        void CreateFrameResources();
 
         void CreatePipelines();
 
@@ -398,55 +791,156 @@ Engine {
 
         void CreatePipelineEllipse();
 
-        void SubmitTriangleBatchRendering();
+        void CreatePipelineSprite();
+
+        void CreatePipelineClipStencil();
+
+        // One pipeline per ShaderPermutation, DrawPass and ClipStencilTest, all with the scissor and depth tests
+        // enabled. Primitive types that are never opaque leave the DrawPass::Opaque ones empty, permutations
+        // without a pixel shader are left empty as well.
+        void CreatePipelineVariants(nvrhi::GraphicsPipelineDesc desc, PipelineVariants &variants,
+                                    const PixelShaderPermutations &pixelShaders, bool hasOpaqueDraws);
+
+        void PrepareTriangleRendering();
+
+        void PrepareLineRendering();
+
+        void PrepareEllipseRendering();
+
+        void PrepareSpriteRendering();
 
-        void SubmitLineBatchRendering();
+        void PrepareStaticBatchRendering();
 
-        void SubmitEllipseBatchRendering();
+        void BuildStaticBatch(StaticBatch &batch);
+
+        void UpdateFrameBindingSets();
+
+        // Orders entries by (depth, type), keeping submission order within each pair
+        void SortDrawStream(std::vector<DrawStreamEntry> &stream);
+
+        // Numbers the primitives of the sorted frame draw stream, static batch instances included, and sets the
+        // depth scale from the total
+        void AssignDrawOrdinals();
+
+        [[nodiscard]] nvrhi::IBindingSet *GetFrameBindingSet(PrimitiveType type) const;
+
+        void BindPrimitive(PrimitiveType type, ShaderPermutation permutation, DrawPass pass,
+                           nvrhi::IBindingSet *bindingSetSpace0, const ClipState &clip);
+
+        // entry's ordinals are relative to ordinalBase, which is nonzero for static batch content
+        void DrawPrimitives(const DrawStreamEntry &entry, nvrhi::IBindingSet *bindingSetSpace0,
+                            const ClipState &clip, uint32_t ordinalBase);
+
+        // Scissor rect or stencil test for clip, whose points viewProjection maps to clip space. Writes the clip
+        // into the stencil buffer unless it is the one written last.
+        [[nodiscard]] ClipState ResolveClipState(const ClipRegion *clip, const glm::mat4 &viewProjection);
+
+        void WriteClipStencil(const glm::mat4x2 &points);
+
+        // Draws the instance's entries of pass, in reverse for DrawPass::Opaque
+        void DrawStaticBatchInstance(const StaticBatchDraw &draw, DrawPass pass);
+
+        void DrawStream();
 
         void Submit();
 
         void RecalculateViewProjectionMatrix();
 
+        void MergeRecorders();
+
         nvrhi::DeviceHandle mDevice;
         glm::u32vec2 mOutputSize;
         glm::vec2 mVirtualSize;
         glm::mat4 mViewProjectionMatrix;
+        glm::vec4 mVisibleBounds;
+        float mPixelSize = 1.0f;  // Virtual units per output pixel
 
         nvrhi::TextureHandle mTexture;
+        nvrhi::TextureHandle mDepthStencilTexture;
         nvrhi::FramebufferHandle mFramebuffer;
 
+        // Render targets replaced by OnResize, kept until RetiredFrame and every frame before it have completed
+        struct RetiredRenderTargets {
+            nvrhi::TextureHandle Texture;
+            nvrhi::TextureHandle DepthStencilTexture;
+            nvrhi::FramebufferHandle Framebuffer;
+            uint64_t RetiredFrame;
+        };
+
+        std::vector<RetiredRenderTargets> mRetiredRenderTargets;
+        bool mRenderTargetsOutdated = false;  // mOutputSize changed since the targets were created
+        float mResizeMilliseconds = 0.0f;
+
         VirtualTextureManager mVirtualTextureManager;
+        std::mutex mVirtualTextureMutex;
 
-        size_t mBindlessTextureArraySizeMax{};
         nvrhi::CommandListHandle mCommandList;
         nvrhi::SamplerHandle mTextureSampler;
 
-        int mCurrentDepth = 0;
-
-        TriangleRenderingCommandList mTriangleCommandList;
-        nvrhi::InputLayoutHandle mTriangleInputLayout;
-        nvrhi::GraphicsPipelineHandle mTrianglePipeline;
+        std::vector<std::unique_ptr<Renderer2DRecorder>> mRecorders;
+        std::mutex mRecordersMutex;
+
+        ThreadPool mSubmissionThreadPool;
+
+        uint32_t mFramesInFlight;
+        uint32_t mFrameSlot = 0;
+        uint64_t mFrameCount = 0;
+        std::vector<FrameRenderingResources> mFrameResources;
+
+        std::vector<DrawStreamEntry> mDrawStream;
+        std::vector<DrawStreamEntry> mSortedDrawStream;
+        std::vector<DrawStreamEntry> mMergedDrawStream;
+        std::vector<SortKey> mDrawStreamKeys;
+        std::vector<SortKey> mDrawStreamKeyScratch;
+        Renderer2DStatistics mStatistics;
+
+        // Elements written to each upload buffer last frame, and how many frames in a row wrote the same counts.
+        // Once every frame slot saw them, the upload buffers must not grow again, see Submit.
+        std::array<size_t, 5> mUploadSizes{};
+        uint32_t mSteadyUploadFrames = 0;
+
+        float mOrdinalScale = 0.0f;  // See DepthConstants
+
+        // Bound while replaying the draw stream
+        std::optional<PrimitiveType> mBoundType;
+        DrawPass mBoundPass = DrawPass::Translucent;
+        ShaderPermutation mBoundPermutation = ShaderPermutation::Plain;
+        nvrhi::IBindingSet *mBoundBindingSet = nullptr;
+        ClipState mBoundClip;
+
+        // Clips of the frame's draw stream. The stencil buffer holds the clip written last under
+        // mStencilReference, earlier clips keep their older values and are rewritten when used again. The top
+        // bit is reserved for filling the clip polygon, see CreatePipelineClipStencil.
+        static constexpr uint8_t ClipStencilParityBit = 0x80;
+        ClipRegionTable mFrameClips;
+        uint8_t mStencilReference = 0;
+        std::optional<glm::mat4x2> mStencilClipPoints;  // Clip space, of the clip written last
+        nvrhi::GraphicsPipelineHandle mClipStencilParityPipeline;
+        nvrhi::GraphicsPipelineHandle mClipStencilResolvePipeline;
+        nvrhi::BindingLayoutHandle mClipStencilBindingLayout;
+        nvrhi::BindingSetHandle mClipStencilBindingSet;
+
+        std::vector<StaticBatchDraw> mStaticDraws;
+        nvrhi::BufferHandle mStaticBatchConstantBuffer;  // Volatile, rewritten for every static batch draw
+
+        PipelineVariants mTrianglePipelines;
         nvrhi::BindingLayoutHandle mTriangleBindingLayoutSpace0;
-        nvrhi::BindingLayoutHandle mTriangleBindingLayoutSpace1;
         nvrhi::BufferHandle mTriangleConstantBuffer;
-        size_t mTriangleBufferInstanceSizeMax;
-        std::vector<TriangleBatchRenderingResources> mTriangleBatchRenderingResources;
+        TriangleFrameUploadBuffers mTriangleUpload;
 
-        LineRenderingCommandList mLineCommandList;
-        nvrhi::InputLayoutHandle mLineInputLayout;
-        nvrhi::GraphicsPipelineHandle mLinePipeline;
+        PipelineVariants mLinePipelines;
         nvrhi::BindingLayoutHandle mLineBindingLayoutSpace0;
         nvrhi::BufferHandle mLineConstantBuffer;
-        size_t mLineBufferVertexSizeMax;
-        std::vector<LineBatchRenderingResources> mLineBatchRenderingResources;
+        LineFrameUploadBuffers mLineUpload;
 
-        EllipseRenderingCommandList mEllipseCommandList;
-        nvrhi::GraphicsPipelineHandle mEllipsePipeline;
+        PipelineVariants mEllipsePipelines;
         nvrhi::BindingLayoutHandle mEllipseBindingLayoutSpace0;
-        nvrhi::BindingLayoutHandle mEllipseBindingLayoutSpace1;
         nvrhi::BufferHandle mEllipseConstantBuffer;
-        size_t mEllipseBufferInstanceSizeMax;
-        std::vector<EllipseBatchRenderingResources> mEllipseBatchRenderingResources;
+        EllipseFrameUploadBuffers mEllipseUpload;
+
+        // Sprites bind the same resources as triangles and share their binding layouts
+        PipelineVariants mSpritePipelines;
+        nvrhi::BufferHandle mSpriteConstantBuffer;
+        SpriteFrameUploadBuffers mSpriteUpload;
     };
 }
@@ -38,8 +38,10 @@ namespace Engine {
                           const nvrhi::vulkan::DeviceHandle& nvrhiDevice,
                           vk::SwapchainKHR oldSwapchain = nullptr);
 
-        /// Recreate swapchain (e.g., on window resize)
-        void Recreate(SDL_Window* window,
+        /// Recreate swapchain (e.g., on window resize) without waiting for the device
+        /// @return The previous swapchain, retired but possibly still in use by frames in flight. Keep it alive
+        /// until they have completed.
+        [[nodiscard]] PlatformSwapchain Recreate(SDL_Window* window,
                       const vk::SharedSurfaceKHR& platformSurface,
                       const vk::SharedPhysicalDevice& physicalDevice,
                       const vk::SharedDevice& device,
@@ -212,15 +214,17 @@ namespace Engine {
         *this = CreateSwapchainInternal(window, platformSurface, physicalDevice, device, nvrhiDevice, oldSwapchain);
     }
 
-    inline void PlatformSwapchain::Recreate(
+    inline PlatformSwapchain PlatformSwapchain::Recreate(
         SDL_Window* window,
         const vk::SharedSurfaceKHR& platformSurface,
         const vk::SharedPhysicalDevice& physicalDevice,
         const vk::SharedDevice& device,
         const nvrhi::vulkan::DeviceHandle& nvrhiDevice) {
-        device->waitIdle();
         vk::SwapchainKHR oldSwapchain = mSwapchain ? mSwapchain.get() : nullptr;
-        *this = CreateSwapchainInternal(window, platformSurface, physicalDevice, device, nvrhiDevice, oldSwapchain);
+        PlatformSwapchain swapchain = CreateSwapchainInternal(window, platformSurface, physicalDevice, device,
+                                                              nvrhiDevice, oldSwapchain);
+        std::swap(*this, swapchain);
+        return swapchain;
     }
 
     inline SwapchainAcquireResult PlatformSwapchain::AcquireNextImage(
@@ -0,0 +1,165 @@
+module Render.TextureUploader;
+
+import Vendor.ApplicationAPI;
+import Core.Prelude;
+import Render.Image;
+
+namespace Engine {
+    namespace {
+        uint32_t GetRowPitch(const SimpleGPUImageDescriptor &descriptor) {
+            return descriptor.rowPitchInBytes.value_or(descriptor.width * sizeof(uint32_t));
+        }
+
+        uint64_t GetUploadSize(const SimpleGPUImageDescriptor &descriptor) {
+            return static_cast<uint64_t>(GetRowPitch(descriptor)) * descriptor.height;
+        }
+
+        // Only textures that are sampled and never written afterwards can take the copy queue, their state after
+        // the upload is made permanent on the graphics queue. Anything else is uploaded like UploadImagesToGPU does.
+        bool CanUseCopyQueue(const SimpleGPUImageDescriptor &descriptor) {
+            return !descriptor.isRenderTarget && !descriptor.isUAV && descriptor.keepInitialState;
+        }
+    }
+
+    TextureUploader::TextureUploader(nvrhi::IDevice *device, bool useCopyQueue, uint64_t bytesPerFrame)
+        : mDevice(device), mBytesPerFrame(bytesPerFrame) {
+        if (useCopyQueue) {
+            mCopyCommandList = mDevice->createCommandList(nvrhi::CommandListParameters()
+                .setQueueType(nvrhi::CommandQueue::Copy));
+        }
+        mStatistics.UsesCopyQueue = mCopyCommandList != nullptr;
+    }
+
+    std::future<nvrhi::TextureHandle> TextureUploader::Enqueue(const SimpleGPUImageDescriptor &descriptor,
+                                                                std::shared_ptr<const void> keepAlive) {
+        if (descriptor.width == 0 || descriptor.height == 0) {
+            throw Engine::RuntimeException("TextureUploader: Cannot upload an empty image.");
+        }
+        // The last row does not need to be padded to the full pitch
+        const uint64_t requiredBytes = static_cast<uint64_t>(GetRowPitch(descriptor)) * (descriptor.height - 1) +
+                                       descriptor.width * sizeof(uint32_t);
+        if (descriptor.imageData.size_bytes() < requiredBytes) {
+            throw Engine::RuntimeException("TextureUploader: Image data is smaller than its dimensions.");
+        }
+
+        PendingUpload upload{
+            .Descriptor = descriptor,
+            .DebugName = std::string(descriptor.debugName),
+            .KeepAlive = std::move(keepAlive)
+        };
+        std::future<nvrhi::TextureHandle> future = upload.Promise.get_future();
+
+        std::lock_guard lock(mMutex);
+        mPending.push_back(std::move(upload));
+        ++mStatistics.PendingUploads;
+        return future;
+    }
+
+    std::future<nvrhi::TextureHandle> TextureUploader::Enqueue(const CPUSimpleImage &image,
+                                                                std::string_view debugName) {
+        return Enqueue(image.GetGPUDescriptor(debugName), image.data);
+    }
+
+    void TextureUploader::Process(nvrhi::ICommandList *graphicsCommandList) {
+        std::vector<PendingUpload> batch;
+        {
+            std::lock_guard lock(mMutex);
+
+            uint64_t bytes = 0;
+            while (!mPending.empty()) {
+                const uint64_t size = GetUploadSize(mPending.front().Descriptor);
+                if (!batch.empty() && bytes + size > mBytesPerFrame) {
+                    break;
+                }
+                bytes += size;
+                batch.push_back(std::move(mPending.front()));
+                mPending.pop_front();
+            }
+
+            mStatistics.PendingUploads = static_cast<uint32_t>(mPending.size());
+            mStatistics.UploadsThisFrame = static_cast<uint32_t>(batch.size());
+            mStatistics.BytesThisFrame = bytes;
+            mStatistics.TotalBytes += bytes;
+        }
+
+        if (batch.empty()) {
+            return;
+        }
+
+        std::vector<RecordedUpload> copied;
+        for (auto &upload: batch) {
+            // Moving the upload may have moved the name's characters, point at where they live now
+            upload.Descriptor.debugName = upload.DebugName;
+            const SimpleGPUImageDescriptor &descriptor = upload.Descriptor;
+            if (!mCopyCommandList || !CanUseCopyQueue(descriptor)) {
+                nvrhi::TextureHandle texture = CreateTexture(descriptor);
+                graphicsCommandList->writeTexture(texture, 0, 0, descriptor.imageData.data(),
+                                                  GetRowPitch(descriptor));
+                upload.Promise.set_value(std::move(texture));
+                continue;
+            }
+
+            if (copied.empty()) {
+                mCopyCommandList->open();
+            }
+
+            SimpleGPUImageDescriptor copyDescriptor = descriptor;
+            copyDescriptor.initialState = nvrhi::ResourceStates::CopyDest;
+            copyDescriptor.keepInitialState = false;
+            nvrhi::TextureHandle texture = CreateTexture(copyDescriptor);
+
+            mCopyCommandList->beginTrackingTextureState(texture, nvrhi::AllSubresources,
+                                                        nvrhi::ResourceStates::Unknown);
+            mCopyCommandList->writeTexture(texture, 0, 0, descriptor.imageData.data(), GetRowPitch(descriptor));
+            copied.push_back({
+                .Texture = std::move(texture),
+                .FinalState = descriptor.initialState,
+                .Promise = std::move(upload.Promise)
+            });
+        }
+
+        if (copied.empty()) {
+            return;
+        }
+
+        // writeTexture has already copied the pixels into staging memory, the sources can go with the batch
+        mCopyCommandList->close();
+        const uint64_t instance = mDevice->executeCommandList(mCopyCommandList, nvrhi::CommandQueue::Copy);
+        mDevice->queueWaitForCommandList(nvrhi::CommandQueue::Graphics, nvrhi::CommandQueue::Copy, instance);
+
+        for (auto &upload: copied) {
+            graphicsCommandList->beginTrackingTextureState(upload.Texture, nvrhi::AllSubresources,
+                                                           nvrhi::ResourceStates::CopyDest);
+            graphicsCommandList->setPermanentTextureState(upload.Texture, upload.FinalState);
+        }
+        graphicsCommandList->commitBarriers();
+
+        for (auto &upload: copied) {
+            upload.Promise.set_value(std::move(upload.Texture));
+        }
+    }
+
+    void TextureUploader::SetBytesPerFrame(uint64_t bytesPerFrame) {
+        std::lock_guard lock(mMutex);
+        mBytesPerFrame = bytesPerFrame;
+    }
+
+    TextureUploaderStatistics TextureUploader::GetStatistics() const {
+        std::lock_guard lock(mMutex);
+        return mStatistics;
+    }
+
+    nvrhi::TextureHandle TextureUploader::CreateTexture(const SimpleGPUImageDescriptor &descriptor) const {
+        nvrhi::TextureDesc textureDesc;
+        textureDesc.width = descriptor.width;
+        textureDesc.height = descriptor.height;
+        textureDesc.format = descriptor.format;
+        textureDesc.debugName = descriptor.debugName;
+        textureDesc.isRenderTarget = descriptor.isRenderTarget;
+        textureDesc.isUAV = descriptor.isUAV;
+        textureDesc.initialState = descriptor.initialState;
+        textureDesc.keepInitialState = descriptor.keepInitialState;
+
+        return mDevice->createTexture(textureDesc);
+    }
+}
@@ -0,0 +1,75 @@
+export module Render.TextureUploader;
+
+import Vendor.ApplicationAPI;
+import Core.Prelude;
+import Render.Image;
+
+namespace Engine {
+    export struct TextureUploaderStatistics {
+        uint32_t PendingUploads = 0;       // Queued and not yet recorded
+        uint32_t UploadsThisFrame = 0;
+        uint64_t BytesThisFrame = 0;
+        uint64_t TotalBytes = 0;
+        bool UsesCopyQueue = false;
+    };
+
+    // Uploads textures over several frames instead of blocking on each one like UploadImagesToGPU.
+    //
+    // Enqueue may be called from any thread and returns a future that becomes ready once the texture can be used by
+    // the graphics queue. Process runs once per frame on the main thread and records uploads up to the byte budget,
+    // so a burst of loads is spread across frames rather than stalling one. An upload larger than the whole budget
+    // still goes through, alone in its frame.
+    //
+    // With a copy queue the uploads are submitted there and the graphics queue waits on them. The textures then
+    // move from CopyDest to their requested initial state in the frame's graphics command list.
+    export class TextureUploader {
+    public:
+        static constexpr uint64_t DefaultBytesPerFrame = 32ull << 20;
+
+        TextureUploader(nvrhi::IDevice *device, bool useCopyQueue, uint64_t bytesPerFrame = DefaultBytesPerFrame);
+
+        TextureUploader(const TextureUploader &) = delete;
+        TextureUploader &operator=(const TextureUploader &) = delete;
+
+        // descriptor.imageData must stay valid until the future is ready, unless keepAlive owns it
+        std::future<nvrhi::TextureHandle> Enqueue(const SimpleGPUImageDescriptor &descriptor,
+                                                  std::shared_ptr<const void> keepAlive = {});
+
+        // Keeps the image's pixels alive until they are uploaded
+        std::future<nvrhi::TextureHandle> Enqueue(const CPUSimpleImage &image,
+                                                  std::string_view debugName = "CPUSimpleImage");
+
+        // Records this frame's share of the queued uploads. graphicsCommandList must be open and is executed after
+        // this call, the textures handed out here are usable from it.
+        void Process(nvrhi::ICommandList *graphicsCommandList);
+
+        void SetBytesPerFrame(uint64_t bytesPerFrame);
+
+        [[nodiscard]] TextureUploaderStatistics GetStatistics() const;
+
+    private:
+        struct PendingUpload {
+            SimpleGPUImageDescriptor Descriptor;
+            std::string DebugName;  // Owned copy of Descriptor.debugName
+            std::shared_ptr<const void> KeepAlive;
+            std::promise<nvrhi::TextureHandle> Promise;
+        };
+
+        struct RecordedUpload {
+            nvrhi::TextureHandle Texture;
+            nvrhi::ResourceStates FinalState;
+            std::promise<nvrhi::TextureHandle> Promise;
+        };
+
+        nvrhi::TextureHandle CreateTexture(const SimpleGPUImageDescriptor &descriptor) const;
+
+        nvrhi::DeviceHandle mDevice;
+        nvrhi::CommandListHandle mCopyCommandList;
+
+        mutable std::mutex mMutex;
+        std::deque<PendingUpload> mPending;
+        uint64_t mBytesPerFrame;
+
+        TextureUploaderStatistics mStatistics;
+    };
+}
@@ -5,71 +5,200 @@ import Core.Prelude;
 
 namespace Engine {
     VirtualTextureManager::VirtualTextureManager(nvrhi::IDevice* device, uint32_t initialMax)
-        : mDevice(device), mMaxTextures(initialMax) {
-        mBindingSetDesc.bindings.reserve(mMaxTextures);
+        : mDevice(device) {
+        vk::PhysicalDevice vkPhysicalDevice = static_cast<vk::PhysicalDevice>(
+            mDevice->getNativeObject(nvrhi::ObjectTypes::VK_PhysicalDevice)
+        );
+
+        auto properties = vkPhysicalDevice.getProperties2<vk::PhysicalDeviceProperties2,
+            vk::PhysicalDeviceVulkan12Properties>();
+        uint32_t hardwareMax = properties.get<vk::PhysicalDeviceVulkan12Properties>()
+            .maxDescriptorSetUpdateAfterBindSampledImages;
+
+        mCapacityLimit = std::min<uint32_t>(1 << 18, hardwareMax);
+        mMaxTextures = std::min(initialMax, mCapacityLimit);
+        mSlots.resize(mMaxTextures);
     }
 
-    uint32_t VirtualTextureManager::RegisterTexture(nvrhi::TextureHandle texture) {
-        if (!texture) return static_cast<uint32_t>(-1);
+    VirtualTextureHandle VirtualTextureManager::RegisterTexture(nvrhi::TextureHandle texture, bool opaque) {
+        if (!texture) return {};
 
         auto it = mTextureToVirtualID.find(texture.Get());
         if (it != mTextureToVirtualID.end()) {
-            return it->second;
+            Slot &slot = mSlots[it->second];
+            slot.LastUsedFrame = mCurrentFrame;
+            if (opaque) {
+                std::atomic_ref(slot.Opaque).store(true, std::memory_order_relaxed);
+            }
+            return {it->second, slot.Generation};
         }
 
-        if (mVirtualTextures.size() >= mMaxTextures) {
+        uint32_t newID;
+        if (!mFreeSlots.empty()) {
+            newID = mFreeSlots.back();
+            mFreeSlots.pop_back();
+        } else if (mUntouchedSlot < mMaxTextures) {
+            newID = mUntouchedSlot++;
+        } else {
             throw Engine::RuntimeException(
                 "VirtualTextureManager: Capacity reached. Call Optimize() or increase limit.");
         }
 
-        uint32_t newID = static_cast<uint32_t>(mVirtualTextures.size());
-        mVirtualTextures.push_back(texture);
+        Slot &slot = mSlots[newID];
+        slot.Texture = texture;
+        slot.LastUsedFrame = mCurrentFrame;
+        std::atomic_ref(slot.Opaque).store(opaque || !nvrhi::getFormatInfo(texture->getDesc().format).hasAlpha,
+                                           std::memory_order_relaxed);
         mTextureToVirtualID[texture.Get()] = newID;
+        ++mOccupiedSlots;
 
-        mBindingSetDesc.addItem(nvrhi::BindingSetItem::Texture_SRV(0, texture)
-            .setArrayElement(newID));
+        if (mDescriptorTable) {
+            mDevice->writeDescriptorTable(mDescriptorTable, nvrhi::BindingSetItem::Texture_SRV(newID, texture));
+        }
+
+        return {newID, slot.Generation};
+    }
+
+    bool VirtualTextureManager::IsValid(VirtualTextureHandle handle) const {
+        return handle.Slot < mSlots.size() && mSlots[handle.Slot].Generation == handle.Generation;
+    }
+
+    bool VirtualTextureManager::IsOpaque(uint32_t virtualID) const {
+        // Relaxed is enough, the flag guards no other data
+        return virtualID < mSlots.size() &&
+               std::atomic_ref(mSlots[virtualID].Opaque).load(std::memory_order_relaxed);
+    }
+
+    void VirtualTextureManager::MarkUsed(std::span<const int32_t> virtualIDs) {
+        for (int32_t virtualID: virtualIDs) {
+            if (virtualID >= 0) {
+                mSlots[virtualID].LastUsedFrame = mCurrentFrame;
+            }
+        }
+    }
+
+    void VirtualTextureManager::MarkUsed(uint32_t virtualID) {
+        mSlots[virtualID].LastUsedFrame = mCurrentFrame;
+    }
+
+    void VirtualTextureManager::BeginFrame(uint64_t frameIndex, uint64_t retiredFrameIndex) {
+        mCurrentFrame = frameIndex;
+        if (!IsSubOptimal()) {
+            return;
+        }
 
-        mIsDirty = true;
-        return newID;
+        std::vector<uint32_t> candidates;
+        for (uint32_t i = 0; i < mUntouchedSlot; ++i) {
+            if (mSlots[i].Texture && mSlots[i].LastUsedFrame <= retiredFrameIndex) {
+                candidates.push_back(i);
+            }
+        }
+
+        const uint32_t excess = mOccupiedSlots - std::min(mOccupiedSlots, mMaxTextures / 2);
+        const size_t evictCount = std::min<size_t>(candidates.size(), excess);
+        auto leastRecentlyUsed = [&](uint32_t a, uint32_t b) {
+            return mSlots[a].LastUsedFrame < mSlots[b].LastUsedFrame;
+        };
+        std::ranges::nth_element(candidates, candidates.begin() + evictCount, leastRecentlyUsed);
+
+        for (size_t i = 0; i < evictCount; ++i) {
+            Evict(candidates[i]);
+        }
     }
 
     void VirtualTextureManager::Optimize() {
-        uint32_t hardLimit = 1 << 18;
-        if (mMaxTextures < hardLimit) {
-            mMaxTextures = std::min(mMaxTextures * 2, hardLimit);
+        if (mMaxTextures >= mCapacityLimit) {
+            return;
         }
 
-        Reset();
+        mMaxTextures = std::min(mMaxTextures * 2, mCapacityLimit);
+        mSlots.resize(mMaxTextures);
+        if (mDescriptorTable) {
+            mDevice->resizeDescriptorTable(mDescriptorTable, mMaxTextures, true);
+        }
+    }
+
+    nvrhi::IBindingLayout *VirtualTextureManager::GetBindingLayout() {
+        if (!mBindingLayout) {
+            nvrhi::BindlessLayoutDesc layoutDesc;
+            layoutDesc.visibility = nvrhi::ShaderType::Pixel;
+            layoutDesc.firstSlot = 0;
+            layoutDesc.maxCapacity = mCapacityLimit;
+            layoutDesc.registerSpaces = {
+                nvrhi::BindingLayoutItem::Texture_SRV(1)
+            };
+
+            mBindingLayout = mDevice->createBindlessLayout(layoutDesc);
+        }
+
+        return mBindingLayout;
     }
 
-    nvrhi::BindingSetHandle VirtualTextureManager::GetBindingSet(nvrhi::IBindingLayout* layout) {
-        if (mIsDirty || !mCurrentBindingSet) {
-            mCurrentBindingSet = mDevice->createBindingSet(mBindingSetDesc, layout);
-            mIsDirty = false;
+    nvrhi::IDescriptorTable *VirtualTextureManager::GetDescriptorTable() {
+        if (!mDescriptorTable) {
+            mDescriptorTable = mDevice->createDescriptorTable(GetBindingLayout());
+            mDevice->resizeDescriptorTable(mDescriptorTable, mMaxTextures, false);
+
+            for (uint32_t i = 0; i < mUntouchedSlot; ++i) {
+                if (mSlots[i].Texture) {
+                    mDevice->writeDescriptorTable(mDescriptorTable,
+                                                  nvrhi::BindingSetItem::Texture_SRV(i, mSlots[i].Texture));
+                }
+            }
         }
 
-        return mCurrentBindingSet;
+        return mDescriptorTable;
+    }
+
+    void VirtualTextureManager::RequireShaderResourceStates(nvrhi::ICommandList *commandList) const {
+        for (uint32_t i = 0; i < mUntouchedSlot; ++i) {
+            if (mSlots[i].Texture) {
+                commandList->setTextureState(mSlots[i].Texture, nvrhi::AllSubresources,
+                                             nvrhi::ResourceStates::ShaderResource);
+            }
+        }
     }
 
     bool VirtualTextureManager::IsSubOptimal() const {
-        return mVirtualTextures.size() >= mMaxTextures * 3 / 4;
+        return mOccupiedSlots >= mMaxTextures * 3 / 4;
     }
 
     void VirtualTextureManager::Reset() {
-        mVirtualTextures.clear();
-        mTextureToVirtualID.clear();
-        mBindingSetDesc.bindings.clear();
-        mBindingSetDesc.bindings.reserve(mMaxTextures);
-        mCurrentBindingSet = nullptr;
-        mIsDirty = true;
+        for (uint32_t i = 0; i < mUntouchedSlot; ++i) {
+            if (mSlots[i].Texture) {
+                Evict(i);
+            }
+        }
+
+        // Numbering starts over, so the next registrations take slots 0, 1, 2...
+        mFreeSlots.clear();
+        mUntouchedSlot = 0;
     }
 
     uint32_t VirtualTextureManager::GetCurrentSize() const {
-        return static_cast<uint32_t>(mVirtualTextures.size());
+        return mOccupiedSlots;
     }
 
     uint32_t VirtualTextureManager::GetCapacity() const {
         return mMaxTextures;
     }
-}
 
+    uint32_t VirtualTextureManager::GetCapacityLimit() const {
+        return mCapacityLimit;
+    }
+
+    const nvrhi::TextureHandle &VirtualTextureManager::GetTexture(uint32_t virtualID) const {
+        return mSlots.at(virtualID).Texture;
+    }
+
+    void VirtualTextureManager::Evict(uint32_t slot) {
+        // The descriptor keeps pointing at the old texture until the slot is reused, the table is partially
+        // bound and nothing indexes it in the meantime
+        mTextureToVirtualID.erase(mSlots[slot].Texture.Get());
+        mSlots[slot].Texture = nullptr;
+        std::atomic_ref(mSlots[slot].Opaque).store(false, std::memory_order_relaxed);
+        ++mSlots[slot].Generation;
+        mFreeSlots.push_back(slot);
+        --mOccupiedSlots;
+    }
+}
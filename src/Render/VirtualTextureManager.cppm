@@ -4,34 +4,109 @@ import Vendor.ApplicationAPI;
 import Core.Prelude;
 
 namespace Engine {
+    // Slot of a registered texture plus the generation it was registered in. A slot only gets a new generation
+    // when its texture is evicted, so a cached handle stays valid for as long as the texture keeps being drawn.
+    export struct VirtualTextureHandle {
+        static constexpr uint32_t InvalidSlot = static_cast<uint32_t>(-1);
+
+        uint32_t Slot = InvalidSlot;
+        uint32_t Generation = 0;
+
+        [[nodiscard]] bool IsNull() const {
+            return Slot == InvalidSlot;
+        }
+
+        bool operator==(const VirtualTextureHandle &) const = default;
+    };
+
+    // Hands out stable array indices for textures and keeps them in one persistent bindless descriptor table.
+    // Registering a texture writes that single descriptor in place, the table is never rebuilt, and every
+    // pipeline that samples the textures shares the same layout and table.
+    //
+    // Slots are stamped with the frame they were last used in. Once the table fills up, the least recently used
+    // slots that no frame in flight can still sample are evicted and reused, every other slot keeps its index.
     export class VirtualTextureManager {
     public:
-        explicit VirtualTextureManager(nvrhi::IDevice* device, uint32_t initialMax = 65536);
+        explicit VirtualTextureManager(nvrhi::IDevice* device, uint32_t initialMax = 16384);
+
+        // Slot of texture, registering it in a free slot if needed and marking it used in the current frame.
+        // Costs a hash lookup, callers that draw the same texture every frame can cache the handle instead.
+        // opaque promises that every texel has an alpha of 1, formats without alpha are opaque on their own.
+        // The flag sticks to the slot until the texture is evicted.
+        VirtualTextureHandle RegisterTexture(nvrhi::TextureHandle texture, bool opaque = false);
+
+        // True while handle's texture still owns its slot. Safe to call while other threads register textures.
+        [[nodiscard]] bool IsValid(VirtualTextureHandle handle) const;
+
+        // True when virtualID's texture was registered as opaque, see RegisterTexture. Safe to call while other
+        // threads register textures.
+        [[nodiscard]] bool IsOpaque(uint32_t virtualID) const;
+
+        // Marks the slots drawn this frame as used, negative IDs are skipped
+        void MarkUsed(std::span<const int32_t> virtualIDs);
+
+        void MarkUsed(uint32_t virtualID);
 
-        uint32_t RegisterTexture(nvrhi::TextureHandle texture);
+        // Starts frameIndex. When the table is more than three quarters full, evicts the least recently used
+        // slots last used in retiredFrameIndex or earlier until it is half full. Frames after retiredFrameIndex
+        // may still be executing, their slots are never evicted. Must not overlap with any registration.
+        void BeginFrame(uint64_t frameIndex, uint64_t retiredFrameIndex);
 
+        // Doubles the capacity, every slot keeps its texture. The caller must make sure no submitted work still
+        // samples the table.
         void Optimize();
 
-        nvrhi::BindingSetHandle GetBindingSet(nvrhi::IBindingLayout* layout);
+        // Bindless layout of the table, created on first use. Bind it as space 1 of pipelines that sample
+        // the textures through an unbounded Texture2D array at t0.
+        [[nodiscard]] nvrhi::IBindingLayout *GetBindingLayout();
+
+        // Created on first use, managers that only hand out IDs never allocate descriptors
+        [[nodiscard]] nvrhi::IDescriptorTable *GetDescriptorTable();
+
+        // Descriptor tables are not state tracked, this requests the shader resource state for every texture
+        // in the table on commandList
+        void RequireShaderResourceStates(nvrhi::ICommandList *commandList) const;
 
         [[nodiscard]] bool IsSubOptimal() const;
 
+        // Evicts every texture and hands out slots from 0 again. Descriptors are overwritten in place as slots are
+        // reused, so no submitted work may still sample the table.
         void Reset();
 
+        // Occupied slots
         [[nodiscard]] uint32_t GetCurrentSize() const;
         [[nodiscard]] uint32_t GetCapacity() const;
 
+        // Largest capacity Optimize can grow the table to
+        [[nodiscard]] uint32_t GetCapacityLimit() const;
+
+        [[nodiscard]] const nvrhi::TextureHandle &GetTexture(uint32_t virtualID) const;
+
     private:
+        struct Slot {
+            nvrhi::TextureHandle Texture;
+            uint64_t LastUsedFrame = 0;
+            uint32_t Generation = 0;
+            // Only accessed through std::atomic_ref, IsOpaque reads it while other threads register textures
+            mutable bool Opaque = false;
+        };
+
+        void Evict(uint32_t slot);
+
         nvrhi::DeviceHandle mDevice;
         uint32_t mMaxTextures;
+        uint32_t mCapacityLimit;  // Largest table the device can bind with update-after-bind descriptors
 
-        std::vector<nvrhi::TextureHandle> mVirtualTextures;
-        std::unordered_map<nvrhi::ITexture*, uint32_t> mTextureToVirtualID;
+        // Sized to the capacity up front, so IsValid can read it while another thread registers a texture
+        std::vector<Slot> mSlots;
+        std::vector<uint32_t> mFreeSlots;  // Evicted slots, reused before untouched ones
+        uint32_t mUntouchedSlot = 0;       // Slots at or after this index were never used
+        uint32_t mOccupiedSlots = 0;
+        uint64_t mCurrentFrame = 0;
 
-        nvrhi::BindingSetDesc mBindingSetDesc;
-        nvrhi::BindingSetHandle mCurrentBindingSet;
+        std::unordered_map<nvrhi::ITexture*, uint32_t> mTextureToVirtualID;
 
-        bool mIsDirty = true;
+        nvrhi::BindingLayoutHandle mBindingLayout;
+        nvrhi::DescriptorTableHandle mDescriptorTable;
     };
 }
-
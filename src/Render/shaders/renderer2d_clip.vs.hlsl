@@ -0,0 +1,17 @@
+// Clip polygon already transformed to clip space, triangles repeat their last point
+struct ClipConstants {
+    float4 points[2]; // xy: first point of the pair, zw: second
+};
+
+[[vk::push_constant]] ConstantBuffer<ClipConstants> u_Clip : register(b0, space0);
+
+// Fan over the four points, the second triangle collapses for triangle clips. Where the triangles of a concave
+// or self-intersecting quad overlap or reach outside it, the stencil parity cancels out.
+static const uint kCorners[6] = { 0, 1, 2, 0, 2, 3 };
+
+float4 main(uint vID : SV_VertexID) : SV_POSITION {
+    uint corner = kCorners[vID % 6];
+    float4 pair = u_Clip.points[corner / 2];
+    float2 position = (corner & 1) != 0 ? pair.zw : pair.xy;
+    return float4(position, 0.0, 1.0);
+}
@@ -2,78 +2,136 @@ cbuffer GlobalConstants : register(b0, space0) {
     float4x4 u_ViewProjectionMatrix;
 };
 
+// Place of the primitive in the draw order, see DepthConstants in Renderer2D.cppm
+struct DepthConstants {
+    int ordinalOffset;
+    float ordinalScale;
+};
+
+[[vk::push_constant]] ConstantBuffer<DepthConstants> u_Depth : register(b1, space0);
+
+// Later primitives are nearer, so opaque ones hide whatever comes before them
+float primitiveDepth(uint primitiveIndex) {
+    return 1.0 - float(int(primitiveIndex) + u_Depth.ordinalOffset + 1) * u_Depth.ordinalScale;
+}
+
 struct EllipseShapeData {
     float2 center;
     float2 radii;
-    float rotation;
-    float innerScale;
+    float2 rotation;    // cos, sin
     float startAngle;
-    float endAngle;
+    float angleSpan;    // counter-clockwise from startAngle, 2 pi for closed shapes
+    float innerScale;
     uint tintColor;
     int textureIndex;
     float edgeSoftness;
-    int clipIndex;  // if < 0, no clipping
-};
-
-struct ClipRegion {
-    float2 points[4]; // in virtual/world space (NOT transformed)
-    uint pointCount;  // 3 or 4
-    uint clipMode;    // 0 = show inside, 1 = show outside
 };
 
 struct PSInput {
     float4 position : SV_POSITION;
-    float2 worldPos : TEXCOORD0;
     float4 tintColor : COLOR0;
-    nointerpolation float2 center : CENTER;
+    float2 localPos : LOCAL_POSITION;
     nointerpolation float2 radii : RADII;
-    nointerpolation float rotation : ROTATION;
     nointerpolation float innerScale : INNER_SCALE;
-    nointerpolation float startAngle : ANGLE_START;
-    nointerpolation float endAngle : ANGLE_END;
+    nointerpolation float4 sectorEdges : SECTOR_EDGES;  // start direction, end direction
+    nointerpolation uint sectorMode : SECTOR_MODE;      // 0 = closed, 1 = span <= pi, 2 = span > pi
     nointerpolation int textureIndex : TEXCOORD1;
     nointerpolation float edgeSoftness : EDGE_SOFTNESS;
-    nointerpolation float2 clipPoints[4] : CLIP_POINTS;
-    nointerpolation uint clipPointCount : CLIP_COUNT;
-    nointerpolation uint clipMode : CLIP_MODE;
 };
 
 StructuredBuffer<EllipseShapeData> u_ShapeBuffer : register(t0, space0);
-StructuredBuffer<ClipRegion> u_ClipBuffer : register(t1, space0);
 
-static const float2 kQuadVertices[6] = {
-    float2(-1.0, -1.0), float2(1.0, -1.0), float2(-1.0, 1.0), // Triangle 1
-    float2(-1.0, 1.0),  float2(1.0, -1.0), float2(1.0, 1.0)   // Triangle 2
+static const float TWO_PI = 6.28318530718;
+
+// Must match EllipseSegments in Renderer2D.cpp
+static const uint kSegments = 8;
+
+// x: step along the arc, y: 0 = inner edge, 1 = outer edge
+static const float2 kSegmentCorners[6] = {
+    float2(0.0, 0.0), float2(1.0, 0.0), float2(0.0, 1.0), // Triangle 1
+    float2(0.0, 1.0), float2(1.0, 0.0), float2(1.0, 1.0)  // Triangle 2
 };
 
+// Angle of the local-space direction angle once the ellipse is squashed to the unit circle
+float unitCircleAngle(float angle, float2 radii) {
+    float s, c;
+    sincos(angle, s, c);
+    return atan2(s / radii.y, c / radii.x);
+}
+
+// Unit circle angle that moves the rim point at unitAngle by margin along the rim
+float rimAngle(float unitAngle, float2 radii, float margin) {
+    float s, c;
+    sincos(unitAngle, s, c);
+    return margin / max(length(float2(-s, c) * radii), 1e-4);
+}
+
 PSInput main(uint vID : SV_VertexID) {
     PSInput output;
 
-    uint shapeIndex = vID / 6;
-    uint vertexInShape = vID % 6;
+    // Each shape is an annulus strip of kSegments quads around the covered angle range. Closed discs and sectors
+    // collapse the inner edge into a fan, rings and arcs skip the hole, so thin shapes rasterize few dead pixels.
+    uint shapeIndex = vID / (kSegments * 6);
+    uint vertexInShape = vID % (kSegments * 6);
+    float2 corner = kSegmentCorners[vertexInShape % 6];
+    float segment = float(vertexInShape / 6) + corner.x;
 
     EllipseShapeData data = u_ShapeBuffer[shapeIndex];
 
-    float maxRadius = max(data.radii.x, data.radii.y);
-    float boundingRadius = maxRadius * 1.05;
-
-    float2 localPos = kQuadVertices[vertexInShape] * boundingRadius;
+    // Room for the anti-aliased edge in world units along each axis, mirrored by the CPU bounds in
+    // EllipseRenderingCommandList::AddEllipse
+    float margin = max(data.edgeSoftness, 0.5) * 2.0;
+    float2 unitMargin = margin / max(data.radii, 1e-4);
+
+    bool closed = data.angleSpan >= TWO_PI - 0.001;
+    float startUnit = 0.0;
+    float spanUnit = TWO_PI;
+    float2 startDir = float2(1.0, 0.0);
+    float2 endDir = float2(1.0, 0.0);
+    if (!closed) {
+        float endAngle = data.startAngle + data.angleSpan;
+        sincos(data.startAngle, startDir.y, startDir.x);
+        sincos(endAngle, endDir.y, endDir.x);
+
+        startUnit = unitCircleAngle(data.startAngle, data.radii);
+        spanUnit = unitCircleAngle(endAngle, data.radii) - startUnit;
+        if (spanUnit <= 0.0) spanUnit += TWO_PI;
+
+        float maxWiden = (TWO_PI - spanUnit) * 0.5;
+        float startWiden = min(rimAngle(startUnit, data.radii, margin), maxWiden);
+        float endWiden = min(rimAngle(startUnit + spanUnit, data.radii, margin), maxWiden);
+        startUnit -= startWiden;
+        spanUnit += startWiden + endWiden;
+    }
 
-    float cosR = cos(data.rotation);
-    float sinR = sin(data.rotation);
-    float2x2 rotMatrix = float2x2(cosR, -sinR, sinR, cosR);
-    float2 rotatedPos = mul(rotMatrix, localPos);
+    // Outer vertices circumscribe the outer ellipse grown by the margin, inner chords stay inside the hole
+    // shrunk by it
+    float step = spanUnit / kSegments;
+    float2 innerRadii = max(data.innerScale - unitMargin, 0.0);
+
+    float2 unitPos;
+    sincos(startUnit + step * segment, unitPos.y, unitPos.x);
+    if (corner.y != 0.0) {
+        unitPos *= (1.0 + unitMargin) / cos(step * 0.5);
+    } else if (closed || any(innerRadii > 0.0)) {
+        unitPos *= innerRadii;
+    } else {
+        // Wedges meet slightly behind the center so the edges along the rays keep their anti-aliasing
+        sincos(startUnit + spanUnit * 0.5, unitPos.y, unitPos.x);
+        unitPos *= -unitMargin;
+    }
 
-    float2 worldPos = data.center + rotatedPos;
+    float2 localPos = unitPos * data.radii;
+    float2 worldPos = data.center + float2(data.rotation.x * localPos.x - data.rotation.y * localPos.y,
+                                           data.rotation.y * localPos.x + data.rotation.x * localPos.y);
 
     output.position = mul(u_ViewProjectionMatrix, float4(worldPos, 0.0, 1.0));
-    output.worldPos = worldPos;
-    output.center = data.center;
+    output.position.z = primitiveDepth(shapeIndex);
+    output.localPos = localPos;
     output.radii = data.radii;
-    output.rotation = data.rotation;
     output.innerScale = data.innerScale;
-    output.startAngle = data.startAngle;
-    output.endAngle = data.endAngle;
+    output.sectorEdges = float4(startDir, endDir);
+    output.sectorMode = closed ? 0 : (data.angleSpan <= TWO_PI * 0.5 ? 1 : 2);
     output.textureIndex = data.textureIndex;
     output.edgeSoftness = data.edgeSoftness;
 
@@ -84,28 +142,5 @@ PSInput main(uint vID : SV_VertexID) {
         (data.tintColor & 0xFF) / 255.0
     );
 
-    // Load clip region (keep in virtual/world space, no transformation needed)
-    if (data.clipIndex >= 0) {
-        ClipRegion clipRegion = u_ClipBuffer[data.clipIndex];
-        output.clipPointCount = clipRegion.pointCount;
-        output.clipMode = clipRegion.clipMode;
-
-        // Pass clip points directly (they're already in virtual space)
-        for (uint i = 0; i < 4; ++i) {
-            if (i < clipRegion.pointCount) {
-                output.clipPoints[i] = clipRegion.points[i];
-            } else {
-                output.clipPoints[i] = float2(0.0, 0.0);
-            }
-        }
-    } else {
-        output.clipPointCount = 0;
-        output.clipMode = 0;
-        output.clipPoints[0] = float2(0.0, 0.0);
-        output.clipPoints[1] = float2(0.0, 0.0);
-        output.clipPoints[2] = float2(0.0, 0.0);
-        output.clipPoints[3] = float2(0.0, 0.0);
-    }
-
     return output;
 }
\ No newline at end of file
@@ -1,8 +1,43 @@
 struct PSInput {
     float4 position : SV_POSITION;
     float4 color : COLOR0;
+    float2 segmentPos : TEXCOORD0; // x along the segment from its start, y across from its center line
+    nointerpolation float segmentLength : TEXCOORD1;
+    nointerpolation float halfWidth : TEXCOORD2;
+    nointerpolation float coverage : TEXCOORD3;
+    nointerpolation uint caps : CAPS;
 };
 
-float4 main(PSInput pixelInput) : SV_TARGET {
-    return pixelInput.color;
-}
\ No newline at end of file
+static const uint kCapSquare = 1;
+static const uint kCapRound = 2;
+
+// Pixels behind opaque draws are rejected before shading, these draws never write depth
+[earlydepthstencil]
+float4 main(PSInput input) : SV_TARGET {
+    // Size of a pixel in segment units, the segment frame is only rotated and scaled uniformly
+    float pixelSize = length(float2(ddx(input.segmentPos.x), ddy(input.segmentPos.x)));
+
+    // Signed distance to the outline of the segment with the cap of its nearer end
+    bool nearStart = input.segmentPos.x < input.segmentLength * 0.5;
+    uint cap = nearStart ? (input.caps & 0x3) : (input.caps >> 2);
+    float overshoot = nearStart ? -input.segmentPos.x : input.segmentPos.x - input.segmentLength;
+    float across = abs(input.segmentPos.y);
+
+    float distance;
+    if (cap == kCapRound) {
+        distance = overshoot > 0.0 ? length(float2(overshoot, across)) - input.halfWidth
+                                   : across - input.halfWidth;
+    } else {
+        float capExtent = cap == kCapSquare ? input.halfWidth : 0.0;
+        distance = max(across - input.halfWidth, overshoot - capExtent);
+    }
+
+    float4 outColor = input.color;
+    outColor.a *= saturate(0.5 - distance / pixelSize) * input.coverage;
+
+    if (outColor.a < 0.001f) {
+        discard;
+    }
+
+    return outColor;
+}
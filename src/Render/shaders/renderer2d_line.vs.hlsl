@@ -1,36 +1,100 @@
 cbuffer GlobalConstants : register(b0, space0) {
     float4x4 u_ViewProjectionMatrix;
+    float u_PixelSize; // virtual units per output pixel
 };
 
-struct VSInput {
-    float2 position : POSITION;
-    uint color : COLOR0;
+// Place of the primitive in the draw order, see DepthConstants in Renderer2D.cppm
+struct DepthConstants {
+    int ordinalOffset;
+    float ordinalScale;
+};
+
+[[vk::push_constant]] ConstantBuffer<DepthConstants> u_Depth : register(b1, space0);
+
+// Later primitives are nearer, so opaque ones hide whatever comes before them
+float primitiveDepth(uint primitiveIndex) {
+    return 1.0 - float(int(primitiveIndex) + u_Depth.ordinalOffset + 1) * u_Depth.ordinalScale;
+}
+
+struct LinePointData {
+    float2 position;
+    uint color;
+    float halfWidth; // 0 for hairlines
+};
+
+struct LineSegmentData {
+    uint firstPoint;
+    uint packedStyle; // bits 0..1: start cap, bits 2..3: end cap
 };
 
 struct PSInput {
     float4 position : SV_POSITION;
     float4 color : COLOR0;
+    float2 segmentPos : TEXCOORD0; // x along the segment from its start, y across from its center line
+    nointerpolation float segmentLength : TEXCOORD1;
+    nointerpolation float halfWidth : TEXCOORD2;
+    nointerpolation float coverage : TEXCOORD3;
+    nointerpolation uint caps : CAPS;
 };
 
-PSInput main(VSInput vertexInput) {
-    PSInput pixelInput;
+StructuredBuffer<LinePointData> u_PointBuffer : register(t0, space0);
+StructuredBuffer<LineSegmentData> u_SegmentBuffer : register(t1, space0);
 
-    // Load position
-    float2 position = vertexInput.position;
+static const uint kCapButt = 0;
+
+// x: 0 at the start point, 1 at the end point; y: side of the center line
+static const float2 kQuadVertices[6] = {
+    float2(0.0, -1.0), float2(1.0, -1.0), float2(0.0, 1.0), // Triangle 1
+    float2(0.0, 1.0),  float2(1.0, -1.0), float2(1.0, 1.0)  // Triangle 2
+};
 
-    // Apply color - same decoding as triangle shader
-    float4 color = float4(
-        ((vertexInput.color >> 24) & 0xFF) / 255.0,
-        ((vertexInput.color >> 16) & 0xFF) / 255.0,
-        ((vertexInput.color >> 8) & 0xFF) / 255.0,
-        (vertexInput.color & 0xFF) / 255.0
+float4 unpackColor(uint color) {
+    return float4(
+        ((color >> 24) & 0xFF) / 255.0,
+        ((color >> 16) & 0xFF) / 255.0,
+        ((color >> 8) & 0xFF) / 255.0,
+        (color & 0xFF) / 255.0
     );
+}
+
+PSInput main(uint vID : SV_VertexID) {
+    PSInput pixelInput;
+
+    LineSegmentData segment = u_SegmentBuffer[vID / 6];
+    float2 corner = kQuadVertices[vID % 6];
+
+    LinePointData p0 = u_PointBuffer[segment.firstPoint];
+    LinePointData p1 = u_PointBuffer[segment.firstPoint + 1];
+
+    uint startCap = segment.packedStyle & 0x3;
+    uint endCap = (segment.packedStyle >> 2) & 0x3;
+
+    float2 delta = p1.position - p0.position;
+    float segmentLength = length(delta);
+    float2 direction = segmentLength > 1e-6 ? delta / segmentLength : float2(1.0, 0.0);
+    float2 normal = float2(-direction.y, direction.x);
+
+    // Lines thinner than a pixel are drawn one pixel wide and faded by their coverage instead
+    float requestedHalfWidth = max(p0.halfWidth, p1.halfWidth);
+    float halfWidth = max(requestedHalfWidth, 0.5 * u_PixelSize);
+    float coverage = requestedHalfWidth > 0.0 ? saturate(requestedHalfWidth / halfWidth) : 1.0;
+
+    // One extra pixel around the line leaves room for the anti-aliased edge
+    float startExtent = (startCap == kCapButt ? 0.0 : halfWidth) + u_PixelSize;
+    float endExtent = (endCap == kCapButt ? 0.0 : halfWidth) + u_PixelSize;
+    float along = corner.x == 0.0 ? -startExtent : segmentLength + endExtent;
+    float across = corner.y * (halfWidth + u_PixelSize);
 
-    // Transform position to clip space
-    float4 clipPosition = mul(u_ViewProjectionMatrix, float4(position, 0.0, 1.0));
+    float2 position = p0.position + direction * along + normal * across;
 
-    pixelInput.position = clipPosition;
-    pixelInput.color = color;
+    pixelInput.position = mul(u_ViewProjectionMatrix, float4(position, 0.0, 1.0));
+    pixelInput.position.z = primitiveDepth(vID / 6);
+    pixelInput.color = lerp(unpackColor(p0.color), unpackColor(p1.color), corner.x);
+    pixelInput.segmentPos = float2(along, across);
+    pixelInput.segmentLength = segmentLength;
+    pixelInput.halfWidth = halfWidth;
+    pixelInput.coverage = coverage;
+    pixelInput.caps = startCap | (endCap << 2);
 
     return pixelInput;
-}
\ No newline at end of file
+}
@@ -0,0 +1,76 @@
+cbuffer GlobalConstants : register(b0, space0) {
+    float4x4 u_ViewProjectionMatrix;
+};
+
+// Place of the primitive in the draw order, see DepthConstants in Renderer2D.cppm
+struct DepthConstants {
+    int ordinalOffset;
+    float ordinalScale;
+};
+
+[[vk::push_constant]] ConstantBuffer<DepthConstants> u_Depth : register(b1, space0);
+
+// Later primitives are nearer, so opaque ones hide whatever comes before them
+float primitiveDepth(uint primitiveIndex) {
+    return 1.0 - float(int(primitiveIndex) + u_Depth.ordinalOffset + 1) * u_Depth.ordinalScale;
+}
+
+struct SpritePrimitiveData {
+    float2 center;
+    uint halfSize;       // half2, x in the low half
+    float rotation;
+    uint uvMin;          // unorm16x2, u in the low half
+    uint uvMax;          // unorm16x2, u in the low half
+    uint tintColor;
+    int textureIndex;    // < 0 means untextured
+};
+
+// Matches the triangle pixel shader, which shades sprites as well
+struct PSInput {
+    float4 position : SV_POSITION;
+    float2 texCoord : TEXCOORD0;
+    float4 tintColor : COLOR0;
+    nointerpolation int textureIndex : TEXCOORD1;
+};
+
+StructuredBuffer<SpritePrimitiveData> u_PrimitiveBuffer : register(t0, space0);
+
+static const float2 kQuadVertices[6] = {
+    float2(-1.0, -1.0), float2(1.0, -1.0), float2(-1.0, 1.0), // Triangle 1
+    float2(-1.0, 1.0),  float2(1.0, -1.0), float2(1.0, 1.0)   // Triangle 2
+};
+
+PSInput main(uint vID : SV_VertexID) {
+    PSInput pixelInput;
+
+    SpritePrimitiveData sprite = u_PrimitiveBuffer[vID / 6];
+    float2 corner = kQuadVertices[vID % 6];
+
+    float2 halfSize = float2(f16tof32(sprite.halfSize & 0xFFFF), f16tof32(sprite.halfSize >> 16));
+    float2 localPos = corner * halfSize;
+
+    float cosR = cos(sprite.rotation);
+    float sinR = sin(sprite.rotation);
+    float2x2 rotMatrix = float2x2(cosR, -sinR, sinR, cosR);
+    float2 position = sprite.center + mul(rotMatrix, localPos);
+
+    // Corner -1 takes the rect's min, +1 its max
+    float2 uvMin = float2(sprite.uvMin & 0xFFFF, sprite.uvMin >> 16) / 65535.0;
+    float2 uvMax = float2(sprite.uvMax & 0xFFFF, sprite.uvMax >> 16) / 65535.0;
+    float2 texCoord = lerp(uvMin, uvMax, corner * 0.5 + 0.5);
+
+    float4 tintColor = float4(
+        ((sprite.tintColor >> 24) & 0xFF) / 255.0,
+        ((sprite.tintColor >> 16) & 0xFF) / 255.0,
+        ((sprite.tintColor >> 8) & 0xFF) / 255.0,
+        (sprite.tintColor & 0xFF) / 255.0
+    );
+
+    pixelInput.position = mul(u_ViewProjectionMatrix, float4(position, 0.0, 1.0));
+    pixelInput.position.z = primitiveDepth(vID / 6);
+    pixelInput.texCoord = texCoord;
+    pixelInput.tintColor = tintColor;
+    pixelInput.textureIndex = sprite.textureIndex;
+
+    return pixelInput;
+}
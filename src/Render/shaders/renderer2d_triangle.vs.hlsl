@@ -2,22 +2,24 @@ cbuffer GlobalConstants : register(b0, space0) {
     float4x4 u_ViewProjectionMatrix;
 };
 
-struct VSInput {
-    float2 position : POSITION;
-    float2 texCoord : TEXCOORD0;
-    uint constantIndex : CONSTANTINDEX0;
+// Place of the primitive in the draw order, see DepthConstants in Renderer2D.cppm
+struct DepthConstants {
+    int ordinalOffset;
+    float ordinalScale;
 };
 
-struct SpriteData {
-    uint tintColor;
-    int textureIndex; // if < 0, no texture
-    int clipIndex;    // if < 0, no clipping
-};
+[[vk::push_constant]] ConstantBuffer<DepthConstants> u_Depth : register(b1, space0);
+
+// Later primitives are nearer, so opaque ones hide whatever comes before them
+float primitiveDepth(uint primitiveIndex) {
+    return 1.0 - float(int(primitiveIndex) + u_Depth.ordinalOffset + 1) * u_Depth.ordinalScale;
+}
 
-struct ClipRegion {
-    float2 points[4]; // in virtual/world space (NOT transformed)
-    uint pointCount;  // 3 or 4
-    uint clipMode;    // 0 = show inside, 1 = show outside
+struct TrianglePrimitiveData {
+    float2 positions[4];
+    uint texCoords[4];   // unorm16x2, u in the low half
+    uint tintColor;
+    uint packedIndices;  // bit 31: quad, bits 0..30: texture index + 1
 };
 
 struct PSInput {
@@ -25,63 +27,45 @@ struct PSInput {
     float2 texCoord : TEXCOORD0;
     float4 tintColor : COLOR0;
     nointerpolation int textureIndex : TEXCOORD1;
-    float2 worldPos : TEXCOORD2;
-    nointerpolation float2 clipPoints[4] : CLIP_POINTS;
-    nointerpolation uint clipPointCount : CLIP_COUNT;
-    nointerpolation uint clipMode : CLIP_MODE;
 };
 
-StructuredBuffer<SpriteData> u_SpriteData : register(t0, space0);
-StructuredBuffer<ClipRegion> u_ClipBuffer : register(t1, space0);
+StructuredBuffer<TrianglePrimitiveData> u_PrimitiveBuffer : register(t0, space0);
+
+// Every primitive expands to 6 vertices, triangles collapse the second half onto corner 0
+static const uint kQuadCorners[6] = { 0, 1, 2, 0, 2, 3 };
+static const uint kTriangleCorners[6] = { 0, 1, 2, 0, 0, 0 };
 
-PSInput main(VSInput vertexInput) {
+PSInput main(uint vID : SV_VertexID) {
     PSInput pixelInput;
 
-    SpriteData sprite = u_SpriteData[vertexInput.constantIndex];
+    TrianglePrimitiveData primitive = u_PrimitiveBuffer[vID / 6];
+
+    bool isQuad = (primitive.packedIndices >> 31) != 0;
+    int textureIndex = int(primitive.packedIndices & 0x7FFFFFFF) - 1;
+
+    uint corner = isQuad ? kQuadCorners[vID % 6] : kTriangleCorners[vID % 6];
 
     // Load position and texture coordinates
-    float2 position = vertexInput.position;
-    float2 texCoord = vertexInput.texCoord;
+    float2 position = primitive.positions[corner];
+    uint packedTexCoord = primitive.texCoords[corner];
+    float2 texCoord = float2(packedTexCoord & 0xFFFF, packedTexCoord >> 16) / 65535.0;
 
     // Apply tint color
     float4 tintColor = float4(
-        ((sprite.tintColor >> 24) & 0xFF) / 255.0,
-        ((sprite.tintColor >> 16) & 0xFF) / 255.0,
-        ((sprite.tintColor >> 8) & 0xFF) / 255.0,
-        (sprite.tintColor & 0xFF) / 255.0
+        ((primitive.tintColor >> 24) & 0xFF) / 255.0,
+        ((primitive.tintColor >> 16) & 0xFF) / 255.0,
+        ((primitive.tintColor >> 8) & 0xFF) / 255.0,
+        (primitive.tintColor & 0xFF) / 255.0
     );
 
     // Transform position to clip space
     float4 clipPosition = mul(u_ViewProjectionMatrix, float4(position, 0.0, 1.0));
+    clipPosition.z = primitiveDepth(vID / 6);
 
     pixelInput.position = clipPosition;
     pixelInput.texCoord = texCoord;
     pixelInput.tintColor = tintColor;
-    pixelInput.textureIndex = sprite.textureIndex;
-    pixelInput.worldPos = position;
-
-    // Load clip region (keep in virtual/world space, no transformation needed)
-    if (sprite.clipIndex >= 0) {
-        ClipRegion clipRegion = u_ClipBuffer[sprite.clipIndex];
-        pixelInput.clipPointCount = clipRegion.pointCount;
-        pixelInput.clipMode = clipRegion.clipMode;
-
-        // Pass clip points directly (they're already in virtual space)
-        for (uint i = 0; i < 4; ++i) {
-            if (i < clipRegion.pointCount) {
-                pixelInput.clipPoints[i] = clipRegion.points[i];
-            } else {
-                pixelInput.clipPoints[i] = float2(0.0, 0.0);
-            }
-        }
-    } else {
-        pixelInput.clipPointCount = 0;
-        pixelInput.clipMode = 0;
-        pixelInput.clipPoints[0] = float2(0.0, 0.0);
-        pixelInput.clipPoints[1] = float2(0.0, 0.0);
-        pixelInput.clipPoints[2] = float2(0.0, 0.0);
-        pixelInput.clipPoints[3] = float2(0.0, 0.0);
-    }
+    pixelInput.textureIndex = textureIndex;
 
     return pixelInput;
 }
\ No newline at end of file